@@ -1,32 +1,12 @@
+#include "AVLTree.h"
+#include "BinaryImage.h"
+#include "Instrumentation.h"
 
 #include <algorithm>
-#include <cmath>
-#include <cstring>
-#include <functional>
-#include <iostream>
-#include <vector>
-#include <queue>
+#include <future>
 #include <sstream>
-#include <tuple>
-
-class AVLNode {
-public:
-    int val;
-    int height;
-    AVLNode* left;
-    AVLNode* right;
-
-    /**
-    * Constructor
-    */
-    explicit AVLNode(int v, AVLNode* l = nullptr, AVLNode* r = nullptr);
-
-    /**
-    * Operator<< Overload to print repr(node)
-    */
-    friend std::ostream& operator<<(std::ostream& out, const AVLNode* node);
-
-};
+#include <stdexcept>
+#include <thread>
 
 
 AVLNode::AVLNode(int v, AVLNode* l, AVLNode* r)
@@ -59,126 +39,116 @@ std::ostream& operator<<(std::ostream& out, const AVLNode* node) {
 }
 
 
-class AVLTree {
-public:
-    AVLNode* root;
-
-    /**
-    * Constructor
-    */
-    AVLTree();
-
-    /**
-    * Insert the given value into the tree, 
-    */
-    void insert(int val);
-
-    /**
-    * Prints inorder traversal to std::cout
-    */
-    void printInorder(AVLNode* node);
-
-
-    /**
-    * Print the level order traversal to the ostream parameter.
-    * By default, it prints to std::cout
-    */
-    void prettyPrint(std::ostream& out = std::cout);
-
-    /**
-    * Deletes the given value from the tree
-    * Returns a bool to denote success of deletion
-    */
-    bool remove(int val);
-
-    /**
-    * Return a pointer to the first node with value == `val`
-    * If such node doesn't exist, return `nullptr`
-    */
-    AVLNode* search(int val);
-
-
-private:
-    /**
-    * Recursive insertion function called by `insert()`
-    */
-    void insertNode(AVLNode* & node, int val);
-
-    /**
-    * Populates the argument std::vector `levels` with tuples where each
-    * tuple holds information about location of an `AVLNode*` in the tree.
-    * (See Parameters for more info.)
-    *
-    * This function is called only by the `prettyPrint()` function,
-    * to pretty print the binary tree.
-    *
-    * Parameters:
-        depth  : distance from root to current node, where depth(root) = 0
-        ai     : is index of node in an array which holds a complete binary tree
-                 if ai is index of current node, then
-                    left child  = 2 * ai + 1
-                    right child = 2* ai + 2
-        levels : A std::vector of std::tuple where each tuple contains
-                   (depth, ai, AVLNode* t)
-    */
-    void preorderLevels(
-        AVLNode* t, 
-        int depth, 
-        int ai, 
-        std::vector<std::tuple<int, int, AVLNode*>>& levels
-    );
+AVLIterator::AVLIterator(AVLNode* root) : root(root), depth(0) {
+}
+
+
+AVLIterator::reference AVLIterator::operator*() const {
+    return path[depth - 1]->val;
+}
+
+
+AVLIterator::pointer AVLIterator::operator->() const {
+    return &path[depth - 1]->val;
+}
+
+
+void AVLIterator::pushLeftmost(AVLNode* node) {
+    while(node != nullptr) {
+        path[depth++] = node;
+        node = node->left;
+    }
+}
 
-    /**
-    * Recursive deletion function called by `remove()`
-    */
-    bool removeNode(AVLNode* & node, int val);
-
-    /**
-    * Rotate LL on critical node
-    * Src: Reema Thareja - Data Structures using C, 2nd Edition
-    *
-    *   Before:                After:
-    *          Cr                 Cn
-    *         /  \               /  \ 
-    *       Cn    T3           T1    Cr
-    *      /  \                     /  \
-    *    T1   T2                   T2  T3
-    *
-    * where Cr: is the critcal node, and argument to this function
-    *       Cn: left child of critical node
-    *
-    */
-    void rotateLL(AVLNode* & node);
-
-    /**
-    * Rotate RR on critical node
-    * Src: Reema Thareja - Data Structures using C, 2nd Edition
-    *
-    *   Before:                After:
-    *          Cr                 Cn
-    *         /  \               /  \ 
-    *       T1    Cn           Cr    T3
-    *            /  \         /  \
-    *          T2   T3      T1    T2
-    *
-    * where Cr: is the critcal node, and argument to this function
-    *       Cn: left child of critical node
-    *
-    */
-    void rotateRR(AVLNode* & node);
-
-    /**
-    * Recursive search function called by `search()`.
-    */
-    AVLNode* searchNode(AVLNode* node, int val);
-
-};
+
+void AVLIterator::pushRightmost(AVLNode* node) {
+    while(node != nullptr) {
+        path[depth++] = node;
+        node = node->right;
+    }
+}
+
+
+AVLIterator& AVLIterator::operator++() {
+    AVLNode* n = path[depth - 1];
+    if(n->right != nullptr) {
+        pushLeftmost(n->right);
+    } else {
+        // Climb up while we come from a right child
+        AVLNode* child;
+        do {
+            child = path[--depth];
+        } while(depth > 0 && path[depth - 1]->right == child);
+    }
+    return *this;
+}
+
+
+AVLIterator& AVLIterator::operator--() {
+    if(depth == 0) {
+        pushRightmost(root);
+        return *this;
+    }
+
+    AVLNode* n = path[depth - 1];
+    if(n->left != nullptr) {
+        pushRightmost(n->left);
+    } else {
+        // Climb up while we come from a left child
+        AVLNode* child;
+        do {
+            child = path[--depth];
+        } while(depth > 0 && path[depth - 1]->left == child);
+    }
+    return *this;
+}
+
+
+AVLIterator AVLIterator::operator++(int) {
+    AVLIterator old = *this;
+    ++(*this);
+    return old;
+}
+
+
+AVLIterator AVLIterator::operator--(int) {
+    AVLIterator old = *this;
+    --(*this);
+    return old;
+}
+
+
+bool AVLIterator::operator==(const AVLIterator& other) const {
+    return node() == other.node();
+}
+
+
+bool AVLIterator::operator!=(const AVLIterator& other) const {
+    return !(*this == other);
+}
+
+
+AVLNode* AVLIterator::node() const {
+    return depth == 0 ? nullptr : path[depth - 1];
+}
+
+
+/**
+* Subtrees shorter than this are never handed to another thread
+* (height 12 is at least ~400 nodes).
+*/
+const int PARALLEL_GRAIN_HEIGHT = 12;
 
 
 AVLTree::AVLTree() : root(nullptr) {
 }
 
 
+AVLTree::~AVLTree() {
+    destroyNode(root);
+}
+
+
 void AVLTree::insert(int val) {
     insertNode(root, val);
 }
@@ -200,9 +170,11 @@ void AVLTree::insertNode(AVLNode* & node, int val) {
 
         if(val >= node->right->val) {
             // RR
+            DS_COUNT(AVL_ROTATIONS_RR, 1);
             rotateRR(node);
         } else {
             // RL
+            DS_COUNT(AVL_ROTATIONS_RL, 1);
             rotateLL(node->right);
             rotateRR(node);
         }
@@ -211,10 +183,11 @@ void AVLTree::insertNode(AVLNode* & node, int val) {
 
         if(val < node->left->val) {
             // LL
-            watch("LL");
+            DS_COUNT(AVL_ROTATIONS_LL, 1);
             rotateLL(node);
         } else {
             // LR
+            DS_COUNT(AVL_ROTATIONS_LR, 1);
             rotateRR(node->left);
             rotateLL(node);
         }
@@ -251,8 +224,8 @@ bool AVLTree::removeNode(AVLNode* & node, int val) {
         } else if (node->left == nullptr || node->right == nullptr) {
             // One child
             AVLNode* temp = node;
-            delete temp;
             node = (node->left != nullptr) ? node->left : node->right;
+            delete temp;
         } else {
             // Two children
 
@@ -281,24 +254,30 @@ bool AVLTree::removeNode(AVLNode* & node, int val) {
         if (hdf > 1) {
             // Rebalance right heavy
 
-            int c = height(node->right) - height(node->left);
-            if(c >= 0) {
+            // Decided by the balance of the child, as removal can leave
+            // it balanced, where a single rotation is enough
+            AVLNode* c = node->right;
+            if(height(c->right) >= height(c->left)) {
                 // RR
+                DS_COUNT(AVL_ROTATIONS_RR, 1);
                 rotateRR(node);
             } else {
                 // RL
+                DS_COUNT(AVL_ROTATIONS_RL, 1);
                 rotateLL(node->right);
                 rotateRR(node);
             }
         } else if (hdf < -1) {
             // Rebalance left heavy
 
-            int c = height(node->right) - height(node->left);
-            if(c < 0) {
+            AVLNode* c = node->left;
+            if(height(c->left) >= height(c->right)) {
                 // LL
+                DS_COUNT(AVL_ROTATIONS_LL, 1);
                 rotateLL(node);
             } else {
                 // LR
+                DS_COUNT(AVL_ROTATIONS_LR, 1);
                 rotateRR(node->left);
                 rotateLL(node);
             }
@@ -321,9 +300,10 @@ void AVLTree::rotateLL(AVLNode* & node) {
     node->left = t2;
     node = temp;
 
-    node->height = 1 + std::max(height(node->left), height(node->right));
+    // Update the demoted node first, the new root depends on it
     AVLNode* orig = node->right;
     orig->height = 1 + std::max(height(orig->left), height(orig->right));
+    node->height = 1 + std::max(height(node->left), height(node->right));
 }
 
 
@@ -336,13 +316,15 @@ void AVLTree::rotateRR(AVLNode* & node) {
     node->right = t2;
     node = temp;
 
-    node->height = 1 + std::max(height(node->left), height(node->right));
+    // Update the demoted node first, the new root depends on it
     AVLNode* orig = node->left;
     orig->height = 1 + std::max(height(orig->left), height(orig->right));
+    node->height = 1 + std::max(height(node->left), height(node->right));
 }
 
 
 AVLNode* AVLTree::search(int val) {
+    DS_COUNT(AVL_SEARCHES, 1);
     return searchNode(root, val);
 }
 
@@ -350,6 +332,7 @@ AVLNode* AVLTree::search(int val) {
 AVLNode* AVLTree::searchNode(AVLNode* node, int val) {
     if(node == nullptr)
         return nullptr;
+    DS_COUNT(AVL_SEARCH_VISITS, 1);
     if(val < node->val) {
         return searchNode(node->left, val);
     } else if (val > node->val) {
@@ -360,244 +343,645 @@ AVLNode* AVLTree::searchNode(AVLNode* node, int val) {
 }
 
 
-void AVLTree::printInorder(AVLNode* n) {
-    if(n != nullptr) {
-        printInorder(n->left);
-        std::cout << n->val << " ";
-        printInorder(n->right);
+void AVLTree::rebalance(AVLNode* & node) {
+
+    int hdf = height(node->right) - height(node->left);
+    if (hdf > 1) {
+        // Rebalance right heavy
+
+        AVLNode* c = node->right;
+        if(height(c->right) >= height(c->left)) {
+            // RR
+            rotateRR(node);
+        } else {
+            // RL
+            rotateLL(node->right);
+            rotateRR(node);
+        }
+    } else if (hdf < -1) {
+        // Rebalance left heavy
+
+        AVLNode* c = node->left;
+        if(height(c->left) >= height(c->right)) {
+            // LL
+            rotateLL(node);
+        } else {
+            // LR
+            rotateRR(node->left);
+            rotateLL(node);
+        }
+    }
+
+    // Update height of critical node
+    node->height = std::max(height(node->left), height(node->right)) + 1;
+}
+
+
+AVLNode* AVLTree::joinNodes(AVLNode* l, AVLNode* k, AVLNode* r) {
+    if(height(l) > height(r) + 1) {
+        return joinRight(l, k, r);
+    } else if(height(r) > height(l) + 1) {
+        return joinLeft(l, k, r);
     }
+
+    k->left = l;
+    k->right = r;
+    k->height = std::max(height(l), height(r)) + 1;
+    return k;
 }
 
 
-void AVLTree::preorderLevels(
-    AVLNode* t, 
-    int depth, 
-    int ai, 
-    std::vector<std::tuple<int, int, AVLNode*>>& levels
-    ) {
+AVLNode* AVLTree::joinRight(AVLNode* l, AVLNode* k, AVLNode* r) {
 
-    if(t != nullptr) {
-        levels.push_back(std::tuple<int,int, AVLNode*>(depth, ai, t));
-        preorderLevels(t->left , depth + 1, 2 * ai + 1, levels);
-        preorderLevels(t->right, depth + 1, 2 * ai + 2, levels);
+    if(height(l->right) <= height(r) + 1) {
+        // Heights match, `k` takes the place of l->right
+        k->left = l->right;
+        k->right = r;
+        k->height = std::max(height(k->left), height(r)) + 1;
+        l->right = k;
+    } else {
+        l->right = joinRight(l->right, k, r);
     }
+
+    rebalance(l);
+    return l;
 }
 
-void AVLTree::prettyPrint(std::ostream& out) {
 
-    std::vector<std::tuple<int, int, AVLNode*>> levels;
-    // Stores pairs of (depth, xval, node)
-    /* where depth: is distance from root, where depth(root) = 0
-             ai   : is index of node if this was a complete binary tree,
-                        stored in an array
-             node : is a pointer to the node
-    */
+AVLNode* AVLTree::joinLeft(AVLNode* l, AVLNode* k, AVLNode* r) {
 
-    preorderLevels(root, 0, 0, levels);
+    if(height(r->left) <= height(l) + 1) {
+        // Heights match, `k` takes the place of r->left
+        k->left = l;
+        k->right = r->left;
+        k->height = std::max(height(l), height(k->right)) + 1;
+        r->left = k;
+    } else {
+        r->left = joinLeft(l, k, r->left);
+    }
 
-    // Sort all the tuples by their depth
-    // if depth is equal, then sort on the `ai` value.
-    std::sort(levels.begin(), levels.end(), 
-        [](std::tuple<int, int, AVLNode*>& p1, std::tuple<int, int, AVLNode*>& p2) {
-            if(std::get<0>(p1) == std::get<0>(p2))
-                return std::get<1>(p1) < std::get<1>(p2);
-            return std::get<0>(p1) < std::get<0>(p2);
-        }
+    rebalance(r);
+    return r;
+}
+
+
+AVLNode* AVLTree::concatNodes(AVLNode* l, AVLNode* r) {
+    if(l == nullptr)
+        return r;
+
+    AVLNode* last = nullptr;
+    l = splitLast(l, last);
+    return joinNodes(l, last, r);
+}
+
+
+AVLNode* AVLTree::splitLast(AVLNode* t, AVLNode* & last) {
+    if(t->right == nullptr) {
+        last = t;
+        AVLNode* rest = t->left;
+        t->left = nullptr;
+        t->height = 0;
+        return rest;
+    }
+
+    t->right = splitLast(t->right, last);
+    rebalance(t);
+    return t;
+}
+
+
+AVLNode* AVLTree::splitNode(AVLNode* t, int val, AVLNode* & lo, AVLNode* & hi) {
+    if(t == nullptr) {
+        lo = hi = nullptr;
+        return nullptr;
+    }
+
+    AVLNode* l = t->left;
+    AVLNode* r = t->right;
+    AVLNode* found = nullptr;
+
+    if(val < t->val) {
+        // `t` and its right subtree belong to `hi`
+        found = splitNode(l, val, lo, l);
+        hi = joinNodes(l, t, r);
+    } else if (val > t->val) {
+        // `t` and its left subtree belong to `lo`
+        found = splitNode(r, val, r, hi);
+        lo = joinNodes(l, t, r);
+    } else {
+        lo = l;
+        hi = r;
+        t->left = t->right = nullptr;
+        t->height = 0;
+        found = t;
+    }
+    return found;
+}
+
+
+bool AVLTree::split(int val, AVLTree& lo, AVLTree& hi) {
+    if(lo.root != nullptr || hi.root != nullptr) {
+        throw std::invalid_argument("AVLTree::split needs empty `lo` and `hi`");
+    }
+    AVLNode* found = splitNode(root, val, lo.root, hi.root);
+    root = nullptr;
+    delete found;
+    return found != nullptr;
+}
+
+
+void AVLTree::join(AVLTree& hi) {
+    root = concatNodes(root, hi.root);
+    hi.root = nullptr;
+}
+
+
+template<typename F, typename G>
+void AVLTree::forkJoin(bool parallel, F f, G g) {
+    if(parallel) {
+        auto task = std::async(std::launch::async, f);
+        g();
+        task.get();
+    } else {
+        f();
+        g();
+    }
+}
+
+
+int AVLTree::forkBudget(unsigned threads) {
+    if(threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if(threads <= 1)
+        return 0;
+
+    // log2(threads) levels give one task per thread, 2 more give 4 per thread
+    int forks = 2;
+    for(unsigned n = threads; n > 1; n >>= 1) {
+        ++forks;
+    }
+    return forks;
+}
+
+
+AVLNode* AVLTree::unionNodes(AVLNode* a, AVLNode* b, int forks) {
+    if(a == nullptr)
+        return b;
+    if(b == nullptr)
+        return a;
+
+    // Decided before the split, which consumes `b`
+    bool parallel = forks > 0 &&
+        std::min(height(a), height(b)) >= PARALLEL_GRAIN_HEIGHT;
+
+    AVLNode* bl = nullptr;
+    AVLNode* br = nullptr;
+    AVLNode* dup = splitNode(b, a->val, bl, br);
+    delete dup;
+
+    AVLNode* al = a->left;
+    AVLNode* ar = a->right;
+    forkJoin(parallel,
+        [&]() { al = unionNodes(al, bl, forks - 1); },
+        [&]() { ar = unionNodes(ar, br, forks - 1); }
     );
 
-    // Get maxDepth from the last tuple of `levels`
-    int maxDepth = std::get<0>(levels.back());
+    return joinNodes(al, a, ar);
+}
+
+
+AVLNode* AVLTree::intersectNodes(AVLNode* a, AVLNode* b, int forks) {
+    if(a == nullptr || b == nullptr) {
+        destroyNode(a);
+        destroyNode(b);
+        return nullptr;
+    }
 
-    // NOTE: Both have to be odd, to center properly
-    // TODO: Calculate width, based on max size of string of node or some heuristic
-    const int WIDTH = 5; // Width of each node
-    const int SPACE = 1; // Space between node at deepest level
-    // Works with SPACE = 1
-    /*
-        Seems to work properly with
-        width space
-        3     1
-        5     1
-        7     1
-    */
+    // Decided before the split, which consumes `b`
+    bool parallel = forks > 0 &&
+        std::min(height(a), height(b)) >= PARALLEL_GRAIN_HEIGHT;
 
-    const int p2n = 1 << maxDepth; // No of nodes at maxDepth ie 2^maxDepth
+    AVLNode* bl = nullptr;
+    AVLNode* br = nullptr;
+    AVLNode* dup = splitNode(b, a->val, bl, br);
+
+    AVLNode* al = a->left;
+    AVLNode* ar = a->right;
+    forkJoin(parallel,
+        [&]() { al = intersectNodes(al, bl, forks - 1); },
+        [&]() { ar = intersectNodes(ar, br, forks - 1); }
+    );
 
-    const int R = maxDepth + 1;                     // Rows for print string
-    const int C = p2n * WIDTH + (p2n - 1) * SPACE;  // Cols for print string
+    if(dup != nullptr) {
+        // `a->val` is in both trees, keep it
+        delete dup;
+        return joinNodes(al, a, ar);
+    }
+    delete a;
+    return concatNodes(al, ar);
+}
 
-    // Change this to a non blank character to see
-    // where the nodes will be placed.
-    const char PLACEHOLDER = ' '; 
 
-    // Allocation
-    const char BLANK = ' ';
-    char** arr = new char*[R];
-    for(int i = 0; i < R; ++i) {
-        arr[i] = new char[C+1];
-        memset(arr[i], BLANK, C * sizeof(char));
-        arr[i][C] = '\0';
+AVLNode* AVLTree::differenceNodes(AVLNode* a, AVLNode* b, int forks) {
+    if(a == nullptr || b == nullptr) {
+        destroyNode(b);
+        return a;
     }
 
-    const int totalNodes = (1 << (maxDepth + 1)) - 1;
-    std::vector<int> locations(totalNodes, -1);
-    // Stores the x-location of a node in it's depth row
-    // locations[5] = 12;
-    // means index=5 node in a complete binary tree, at depth <appropriate depth>
-    // is to be printed at char 12 onwards
+    AVLNode* al = nullptr;
+    AVLNode* ar = nullptr;
+    AVLNode* dup = splitNode(a, b->val, al, ar);
+    delete dup;
+
+    AVLNode* bl = b->left;
+    AVLNode* br = b->right;
+    bool parallel = forks > 0 &&
+        std::min(height(al), height(ar)) >= PARALLEL_GRAIN_HEIGHT;
+
+    forkJoin(parallel,
+        [&]() { al = differenceNodes(al, bl, forks - 1); },
+        [&]() { ar = differenceNodes(ar, br, forks - 1); }
+    );
 
+    delete b;
+    return concatNodes(al, ar);
+}
 
-    for(int r = R-1; r >= 0; --r) {
 
-        int start(0);
-        if(maxDepth - r != 0) {
-            // Nodes under this node, but only left half
-            int underNodes = 1 << (maxDepth - r - 1); 
+void AVLTree::unionWith(AVLTree& other, unsigned threads) {
+    root = unionNodes(root, other.root, forkBudget(threads));
+    other.root = nullptr;
+}
 
-            start = underNodes * WIDTH + (underNodes-1) * SPACE - WIDTH/2 ;
-        }
 
-        int gap(0);
-        if(maxDepth - r == 0) {
-            gap = SPACE;
+void AVLTree::intersectWith(AVLTree& other, unsigned threads) {
+    root = intersectNodes(root, other.root, forkBudget(threads));
+    other.root = nullptr;
+}
+
+
+void AVLTree::differenceWith(AVLTree& other, unsigned threads) {
+    root = differenceNodes(root, other.root, forkBudget(threads));
+    other.root = nullptr;
+}
+
+
+void AVLTree::buildFromSorted(const std::vector<int>& v) {
+    destroyNode(root);
+    root = buildNodes(v, 0, v.size());
+}
+
+
+AVLNode* AVLTree::buildNodes(const std::vector<int>& v, size_t lo, size_t hi) {
+    if(lo == hi)
+        return nullptr;
+
+    size_t mid = lo + (hi - lo) / 2;
+    AVLNode* node = new AVLNode(v[mid]);
+    node->left = buildNodes(v, lo, mid);
+    node->right = buildNodes(v, mid + 1, hi);
+    node->height = std::max(height(node->left), height(node->right)) + 1;
+    return node;
+}
+
+
+void AVLTree::insertBatch(const std::vector<int>& v) {
+    root = insertSorted(root, v, 0, v.size());
+}
+
+
+AVLNode* AVLTree::insertSorted(AVLNode* node, const std::vector<int>& v, size_t lo, size_t hi) {
+    if(lo == hi)
+        return node;
+    if(node == nullptr)
+        return buildNodes(v, lo, hi);
+
+    // Same rule as `insertNode()`: values >= node->val go right
+    size_t mid = std::lower_bound(v.begin() + lo, v.begin() + hi, node->val) - v.begin();
+
+    AVLNode* l = insertSorted(node->left, v, lo, mid);
+    AVLNode* r = insertSorted(node->right, v, mid, hi);
+    return joinNodes(l, node, r);
+}
+
+
+AVLTree::iterator AVLTree::begin() {
+    iterator it(root);
+    it.pushLeftmost(root);
+    return it;
+}
+
+
+AVLTree::iterator AVLTree::end() {
+    return iterator(root);
+}
+
+
+AVLTree::iterator AVLTree::lower_bound(int val) {
+    iterator it(root);
+
+    // Walk down to `val`, remembering the depth of the last candidate
+    int found = 0;
+    AVLNode* n = root;
+    while(n != nullptr) {
+        it.path[it.depth++] = n;
+        if(n->val >= val) {
+            found = it.depth;
+            n = n->left;
         } else {
-            gap = 2 * start + 1;
+            n = n->right;
         }
+    }
+
+    // The path to the candidate is a prefix of the path walked
+    it.depth = found;
+    return it;
+}
 
-        // Index of node in a complete binary tree as array
-        int ai = (1 << r) - 1;
-        for(int i = start; i + WIDTH - 1< C;) {
-            locations[ai] = i;
-            ai++;
-
-            // Uncomment to show where nodes will be placed
-            // if all nodes in complete binary tree existed.
-            // memset(arr[r] + i, PLACEHOLDER, WIDTH);
-            
-            i = i + WIDTH + gap;
+
+AVLTree::iterator AVLTree::upper_bound(int val) {
+    iterator it(root);
+
+    int found = 0;
+    AVLNode* n = root;
+    while(n != nullptr) {
+        it.path[it.depth++] = n;
+        if(n->val > val) {
+            found = it.depth;
+            n = n->left;
+        } else {
+            n = n->right;
         }
+    }
 
+    it.depth = found;
+    return it;
+}
 
-    } // row loop in reverse
 
+void AVLTree::destroyNode(AVLNode* node) {
+    if(node != nullptr) {
+        destroyNode(node->left);
+        destroyNode(node->right);
+        delete node;
+    }
+}
 
-    for(int i = 0; i < levels.size(); ++i) {
-        int depth, ai;
-        AVLNode* node;
-        std::tie(depth, ai, node) = levels[i];
 
-        int xval = locations[ai];
+void AVLTree::printInorder(AVLNode* n) {
+    if(n != nullptr) {
+        printInorder(n->left);
+        std::cout << n->val << " ";
+        printInorder(n->right);
+    }
+}
 
 
-        std::stringstream sv;
-        sv << node;
-        std::string temp;
-        sv >> temp;
+std::string AVLTree::repr(AVLNode* node) {
+    std::stringstream sv;
+    sv << node;
+    return sv.str();
+}
 
-        int inputLength = temp.size();
-        // https://stackoverflow.com/questions/17512825/align-text-to-center-in-string-c
-        int extra = (WIDTH - inputLength)/2;
 
-        // Pads the repr(node) if it's shorter than `WIDTH`
-        // Set to a visible character like 'P' to see the padding
-        const char PAD = BLANK;
-        
-        std::string res;
-        if(extra > 0) {
-            std::string pad = std::string(extra, PAD);
-            res = pad + temp + pad;
+void AVLTree::inorderColumns(
+    AVLNode* t,
+    std::unordered_map<AVLNode*, size_t>& columns,
+    size_t& next
+    ) {
+
+    // Only nodes selected for printing are in `columns`
+    auto it = columns.find(t);
+    if(t == nullptr || it == columns.end())
+        return;
+
+    inorderColumns(t->left, columns, next);
+    it->second = next++;
+    inorderColumns(t->right, columns, next);
+}
+
+
+void AVLTree::prettyPrint(std::ostream& out, int maxDepth, size_t maxNodes) {
+
+    if(root == nullptr || maxNodes == 0) {
+        out << "null" << std::endl;
+        return;
+    }
+
+    // Select the nodes to print in level order, so that every printed node
+    // has its parent printed too. Stores pairs of (node, depth).
+    std::vector<std::pair<AVLNode*, int>> shown;
+    shown.push_back(std::make_pair(root, 0));
+
+    bool truncated = false;
+    for(size_t q = 0; q < shown.size(); ++q) {
+        AVLNode* node = shown[q].first;
+        int depth = shown[q].second;
+
+        for(AVLNode* child : {node->left, node->right}) {
+            if(child == nullptr)
+                continue;
+            if(depth + 1 > maxDepth || shown.size() >= maxNodes) {
+                truncated = true;
+            } else {
+                shown.push_back(std::make_pair(child, depth + 1));
+            }
         }
-        else {
-            res = temp;
+    }
+
+    // Each node gets its own column, in inorder, so that the output is
+    // as wide as the number of printed nodes rather than 2^depth.
+    std::unordered_map<AVLNode*, size_t> columns;
+    columns.reserve(shown.size());
+    size_t width = 0;
+    for(auto& p : shown) {
+        columns[p.first] = 0;
+        width = std::max(width, repr(p.first).size());
+    }
+    size_t next = 0;
+    inorderColumns(root, columns, next);
+
+    // One blank between the widest nodes
+    const size_t WIDTH = width + 1;
+
+    // `shown` holds the rows one after another, each from left to right,
+    // so every row is built and written on its own.
+    std::string line;
+    for(size_t i = 0; i < shown.size();) {
+        int depth = shown[i].second;
+        line.clear();
+
+        for(; i < shown.size() && shown[i].second == depth; ++i) {
+            AVLNode* node = shown[i].first;
+            std::string s = repr(node);
+
+            // Center repr(node) in its column
+            size_t start = columns[node] * WIDTH + (WIDTH - s.size()) / 2;
+            line.resize(start, ' ');
+            line += s;
         }
+        out << line << '\n';
+    }
 
-        // Makes sure a large repr() of a node doesn't exceed the allotted width
-        std::strncpy(arr[depth] + xval, res.c_str(), WIDTH);
+    if(truncated) {
+        out << "... " << shown.size() << " nodes shown, tree truncated" << '\n';
     }
+    out.flush();
+}
+
+
+void AVLTree::exportDot(std::ostream& out) {
+    out << "digraph AVLTree {\n";
+    size_t next = 0;
+    dotNode(out, root, next);
+    out << "}\n";
+}
 
-    // Formatted Pretty Print of the tree
-    for(int i = 0; i < R; ++i) {
-        std::cout << arr[i] << std::endl;
+
+size_t AVLTree::dotNode(std::ostream& out, AVLNode* t, size_t& next) {
+    size_t id = next++;
+    if(t == nullptr) {
+        out << "  n" << id << " [shape=point];\n";
+        return id;
+    }
+
+    out << "  n" << id << " [label=\"" << t->val << " (h=" << t->height << ")\"];\n";
+    if(t->left != nullptr || t->right != nullptr) {
+        size_t l = dotNode(out, t->left, next);
+        size_t r = dotNode(out, t->right, next);
+        out << "  n" << id << " -> n" << l << ";\n";
+        out << "  n" << id << " -> n" << r << ";\n";
     }
+    return id;
+}
 
 
-    // Clean up
-    for(int i = 0; i < R; ++i) {
-        delete[] arr[i];
+void AVLTree::exportJson(std::ostream& out) {
+    jsonNode(out, root);
+    out << '\n';
+}
+
+
+void AVLTree::jsonNode(std::ostream& out, AVLNode* t) {
+    if(t == nullptr) {
+        out << "null";
+        return;
     }
-    delete[] arr;
+
+    out << "{\"val\":" << t->val << ",\"height\":" << t->height << ",\"left\":";
+    jsonNode(out, t->left);
+    out << ",\"right\":";
+    jsonNode(out, t->right);
+    out << '}';
 }
 
 
-int main() {
-    AVLTree tree;
 
-    // When tree empty
-    auto f = tree.search(5);
-    std::cout << "search when tree is empty" << std::endl;
-    std::cout << "Result: " << f << std::endl;
+/**
+* Layout of a node in an image: its value, then
+* height << 2 | has left child << 1 | has right child
+*/
+const int AVL_IMAGE_HAS_LEFT = 2;
+const int AVL_IMAGE_HAS_RIGHT = 1;
+const size_t AVL_IMAGE_BUFFER = 1 << 16;
 
-    // More or less balanced
-    tree.insert(5);
-    tree.insert(2);
-    tree.insert(3);
-    tree.insert(4);
-    tree.insert(6);
-    tree.insert(7);
-    tree.insert(1);
-    tree.insert(8);
-    tree.insert(9);
 
-    // auto g = tree.search(1);
-    // watch("search when present");
-    // watch(g);
+void AVLTree::save(const std::string& path) const {
+    ImageWriter writer(path, "AVLTREE");
+    std::vector<uint32_t> buf;
+    buf.reserve(AVL_IMAGE_BUFFER);
 
-    // auto h = tree.search(99);
-    // watch("search when absent")
-    // watch(h);
+    uint64_t count = saveNode(root, writer, buf);
+    writer.write(buf.data(), buf.size() * sizeof(uint32_t));
+    writer.finish(count, height(root));
+}
 
-    /*
-    Delete individually and check
-    1 leaf (left child)
-    4 leaf (right child)
-    2 one child left
-    6 one child right
-    3 two child (left child of root)
-    7 two child (right child of root)
-    5 two child root
-    */
 
-    int del = 5;
-    bool y = tree.remove(del);
-    std::cout << "delete " << del << std::endl;
-    std::cout << "Was deletion a success? " << std::boolalpha << y << std::endl;
-    tree.prettyPrint();
+uint64_t AVLTree::saveNode(const AVLNode* node, ImageWriter& writer, std::vector<uint32_t>& buf) {
+    if(node == nullptr)
+        return 0;
 
+    if(buf.size() == buf.capacity()) {
+        writer.write(buf.data(), buf.size() * sizeof(uint32_t));
+        buf.clear();
+    }
+    buf.push_back(uint32_t(node->val));
+    buf.push_back(uint32_t(node->height) << 2 |
+        (node->left ? AVL_IMAGE_HAS_LEFT : 0) |
+        (node->right ? AVL_IMAGE_HAS_RIGHT : 0));
+
+    uint64_t count = 1;
+    count += saveNode(node->left, writer, buf);
+    count += saveNode(node->right, writer, buf);
+    return count;
+}
+
+
+bool AVLTree::validNode(AVLNode* node) {
+    if(node == nullptr)
+        return true;
 
+    int hl = height(node->left);
+    int hr = height(node->right);
+    return node->height == std::max(hl, hr) + 1 && hl - hr <= 1 && hr - hl <= 1 &&
+        validNode(node->left) && validNode(node->right);
+}
 
 
-    // Right ladder
-    // tree.insert(1);
-    // tree.insert(2);
-    // tree.insert(3);
-    // tree.insert(4);
-    // tree.insert(5);
-    // tree.insert(6);
+void AVLTree::load(const std::string& path) {
+    MappedFile file(path);
+    ImageHeader header;
+    const uint32_t* rec = reinterpret_cast<const uint32_t*>(
+        openImage(file, "AVLTREE", 2 * sizeof(uint32_t), header));
 
-    // Left ladder
-    // tree.insert(6);
-    // tree.insert(5);
-    // tree.insert(4);
-    // tree.insert(3);
-    // tree.insert(2);
-    // tree.insert(1);
-    
-    
+    // Links still to be filled in, the next record goes into the last one,
+    // with the height of their parent
+    std::vector<std::pair<AVLNode**, int>> pending;
+    pending.reserve(AVL_MAX_HEIGHT + 1);
 
-    // printInorder(tree.root);
+    AVLNode* loaded = nullptr;
+    if(header.count != 0) {
+        pending.push_back(std::make_pair(&loaded, AVL_MAX_HEIGHT));
+    }
 
-    // If tree gets too deep, the pretty print will go out of your screen
-    // tree.prettyPrint();
+    for(uint64_t i = 0; i < header.count; ++i, rec += 2) {
+        if(pending.empty()) {
+            destroyNode(loaded);
+            throw std::runtime_error("AVL tree image has too many nodes");
+        }
+        AVLNode* & slot = *pending.back().first;
+        int parentHeight = pending.back().second;
+        pending.pop_back();
+
+        // Heights decrease down every path, which bounds the depth
+        // by AVL_MAX_HEIGHT before the shape is checked below
+        int h = int(rec[1] >> 2);
+        if(h >= parentHeight) {
+            destroyNode(loaded);
+            throw std::runtime_error("AVL tree image has a wrong height");
+        }
+
+        slot = new AVLNode(int(rec[0]));
+        slot->height = h;
+
+        // Pre-order: the left subtree comes first
+        if(rec[1] & AVL_IMAGE_HAS_RIGHT)
+            pending.push_back(std::make_pair(&slot->right, h));
+        if(rec[1] & AVL_IMAGE_HAS_LEFT)
+            pending.push_back(std::make_pair(&slot->left, h));
+    }
+
+    if(!pending.empty()) {
+        destroyNode(loaded);
+        throw std::runtime_error("AVL tree image has too few nodes");
+    }
+
+    if(!validNode(loaded)) {
+        destroyNode(loaded);
+        throw std::runtime_error("AVL tree image is not balanced");
+    }
 
-    return 0;
+    destroyNode(root);
+    root = loaded;
 }
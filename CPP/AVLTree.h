@@ -0,0 +1,441 @@
+#ifndef AVLTREE_H
+#define AVLTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ImageWriter;
+
+
+class AVLNode {
+public:
+    int val;
+    int height;
+    AVLNode* left;
+    AVLNode* right;
+
+    /**
+    * Constructor
+    */
+    explicit AVLNode(int v, AVLNode* l = nullptr, AVLNode* r = nullptr);
+
+    /**
+    * Operator<< Overload to print repr(node)
+    */
+    friend std::ostream& operator<<(std::ostream& out, const AVLNode* node);
+
+};
+
+
+int height(AVLNode* node);
+
+std::ostream& operator<<(std::ostream& out, const AVLNode* node);
+
+
+/**
+* Upper bound on the height of any AVL tree that fits in memory.
+* An AVL tree of height 92 already holds more than 2^64 nodes.
+*/
+const int AVL_MAX_HEIGHT = 92;
+
+
+class AVLIterator {
+public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef int value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const int* pointer;
+    typedef const int& reference;
+
+    /**
+    * Constructs the end() iterator of the tree rooted at `root`
+    */
+    explicit AVLIterator(AVLNode* root = nullptr);
+
+    reference operator*() const;
+    pointer operator->() const;
+
+    /**
+    * Moves to the in-order successor (resp. predecessor).
+    * The path from the root is kept inside the iterator,
+    * so there is no allocation and nodes need no parent pointer.
+    * Decrementing end() moves to the largest value.
+    */
+    AVLIterator& operator++();
+    AVLIterator& operator--();
+    AVLIterator operator++(int);
+    AVLIterator operator--(int);
+
+    bool operator==(const AVLIterator& other) const;
+    bool operator!=(const AVLIterator& other) const;
+
+    /**
+    * Returns the current node, or `nullptr` for end()
+    */
+    AVLNode* node() const;
+
+private:
+    friend class AVLTree;
+
+    AVLNode* root;
+
+    /**
+    * Nodes from the root down to the current node, which is path[depth - 1].
+    * An empty path (depth == 0) is the end() iterator.
+    */
+    AVLNode* path[AVL_MAX_HEIGHT];
+    int depth;
+
+    /**
+    * Pushes `node` and then its leftmost (resp. rightmost) descendants.
+    */
+    void pushLeftmost(AVLNode* node);
+    void pushRightmost(AVLNode* node);
+};
+
+
+class AVLTree {
+public:
+    AVLNode* root;
+
+    /**
+    * Constructor
+    */
+    AVLTree();
+
+    /**
+    * Destructor, deletes every node.
+    * Trees own their nodes, so they cannot be copied.
+    */
+    ~AVLTree();
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
+
+    /**
+    * Insert the given value into the tree, 
+    */
+    void insert(int val);
+
+    /**
+    * Prints inorder traversal to std::cout
+    */
+    void printInorder(AVLNode* node);
+
+
+    /**
+    * Print the level order traversal to the ostream parameter.
+    * By default, it prints to std::cout
+    *
+    * Rows are written one at a time, each node in its own inorder column,
+    * so memory and line width grow with the number of printed nodes.
+    * Only nodes up to `maxDepth` and the first `maxNodes` nodes in level
+    * order are printed, use `exportDot()` or `exportJson()` for the
+    * whole of a large tree.
+    */
+    void prettyPrint(std::ostream& out = std::cout, int maxDepth = 8, size_t maxNodes = 512);
+
+    /**
+    * Writes the whole tree as a Graphviz digraph, resp. as nested JSON
+    * objects {"val", "height", "left", "right"}.
+    * Nodes are streamed as they are visited, without extra memory.
+    */
+    void exportDot(std::ostream& out);
+    void exportJson(std::ostream& out);
+
+    /**
+    * Deletes the given value from the tree
+    * Returns a bool to denote success of deletion
+    */
+    bool remove(int val);
+
+    /**
+    * Return a pointer to the first node with value == `val`
+    * If such node doesn't exist, return `nullptr`
+    */
+    AVLNode* search(int val);
+
+    /**
+    * Splits the tree around `val` in O(log n).
+    * Values smaller than `val` are moved into `lo`, larger ones into `hi`,
+    * and this tree is left empty. `lo` and `hi` must be empty, otherwise
+    * `std::invalid_argument` is thrown and nothing is moved.
+    * Returns whether `val` was present (its node is deleted).
+    */
+    bool split(int val, AVLTree& lo, AVLTree& hi);
+
+    /**
+    * Appends every node of `hi` to this tree in O(log n), leaving `hi` empty.
+    * Every value in this tree must be smaller than every value in `hi`.
+    */
+    void join(AVLTree& hi);
+
+    /**
+    * Set operations built on `split` / `join`.
+    * Each one consumes `other` (it is left empty) and stores the result
+    * in this tree. Both trees are treated as sets, i.e. without duplicates.
+    *
+    * The two halves of every split are processed in parallel while the
+    * subtrees are large enough to be worth a thread, on up to about
+    * `threads` threads, by default `std::thread::hardware_concurrency()`.
+    * With a single thread everything runs on the calling thread.
+    */
+    void unionWith(AVLTree& other, unsigned threads = 0);
+    void intersectWith(AVLTree& other, unsigned threads = 0);
+    void differenceWith(AVLTree& other, unsigned threads = 0);
+
+    /**
+    * Replaces the contents of the tree with the values of `v`,
+    * which must be sorted in ascending order.
+    * Builds a perfectly balanced tree in O(n), without any rotation.
+    */
+    void buildFromSorted(const std::vector<int>& v);
+
+    /**
+    * Inserts every value of `v`, which must be sorted in ascending order.
+    * The batch is split along the existing tree and every subtree is
+    * rebalanced once with `joinNodes()`, instead of once per value.
+    * Runs in O(m log(n/m + 1)) for m values inserted into n.
+    */
+    void insertBatch(const std::vector<int>& v);
+
+    /**
+    * Writes the tree to `path` as a binary image (see BinaryImage.h),
+    * one 8 byte record per node in pre-order.
+    */
+    void save(const std::string& path) const;
+
+    /**
+    * Replaces the contents of the tree with an image written by `save()`.
+    * The shape is restored as saved, without any comparison or rotation,
+    * and nodes are allocated in pre-order like `buildFromSorted()`.
+    * Throws `std::runtime_error` if the image is missing or damaged,
+    * or does not hold an AVL tree, the tree is then left unchanged.
+    */
+    void load(const std::string& path);
+
+    typedef AVLIterator iterator;
+
+    /**
+    * In-order iterators over the values of the tree.
+    * Inserting or removing values invalidates every iterator.
+    */
+    iterator begin();
+    iterator end();
+
+    /**
+    * Returns an iterator to the first value >= `val` (resp. > `val`),
+    * or end() if there is none. Runs in O(log n).
+    */
+    iterator lower_bound(int val);
+    iterator upper_bound(int val);
+
+    /**
+    * Calls `fn(value)` in order for every value in [lo, hi].
+    * Only the subtrees which may overlap the range are visited,
+    * so it runs in O(log n + k) for k values in the range.
+    */
+    template<typename F>
+    void forEachInRange(int lo, int hi, F fn);
+
+
+private:
+    /**
+    * Recursive insertion function called by `insert()`
+    */
+    void insertNode(AVLNode* & node, int val);
+
+    /**
+    * Returns repr(node), as printed by `operator<<`
+    */
+    std::string repr(AVLNode* node);
+
+    /**
+    * Numbers the nodes of `columns` in inorder, starting from `next`.
+    * Only descends into the nodes present in `columns`.
+    * This function is called only by the `prettyPrint()` function.
+    */
+    void inorderColumns(
+        AVLNode* t,
+        std::unordered_map<AVLNode*, size_t>& columns,
+        size_t& next
+    );
+
+    /**
+    * Recursive exports called by `exportDot()` and `exportJson()`.
+    * `dotNode()` names nodes n0, n1, ... in preorder and returns the
+    * number of `t`.
+    */
+    size_t dotNode(std::ostream& out, AVLNode* t, size_t& next);
+    void jsonNode(std::ostream& out, AVLNode* t);
+
+    /**
+    * Recursive deletion function called by `remove()`
+    */
+    bool removeNode(AVLNode* & node, int val);
+
+    /**
+    * Rotate LL on critical node
+    * Src: Reema Thareja - Data Structures using C, 2nd Edition
+    *
+    *   Before:                After:
+    *          Cr                 Cn
+    *         /  \               /  \ 
+    *       Cn    T3           T1    Cr
+    *      /  \                     /  \
+    *    T1   T2                   T2  T3
+    *
+    * where Cr: is the critcal node, and argument to this function
+    *       Cn: left child of critical node
+    *
+    */
+    void rotateLL(AVLNode* & node);
+
+    /**
+    * Rotate RR on critical node
+    * Src: Reema Thareja - Data Structures using C, 2nd Edition
+    *
+    *   Before:                After:
+    *          Cr                 Cn
+    *         /  \               /  \ 
+    *       T1    Cn           Cr    T3
+    *            /  \         /  \
+    *          T2   T3      T1    T2
+    *
+    * where Cr: is the critcal node, and argument to this function
+    *       Cn: left child of critical node
+    *
+    */
+    void rotateRR(AVLNode* & node);
+
+    /**
+    * Recursive search function called by `search()`.
+    */
+    AVLNode* searchNode(AVLNode* node, int val);
+
+    /**
+    * Restores the AVL property at `node`, whose subtrees may differ in
+    * height by at most 2, and updates its height.
+    */
+    void rebalance(AVLNode* & node);
+
+    /**
+    * Returns a balanced tree made of `l`, then the single node `k`,
+    * then `r`, where all values of `l` < k->val < all values of `r`.
+    * Runs in O(|height(l) - height(r)|).
+    */
+    AVLNode* joinNodes(AVLNode* l, AVLNode* k, AVLNode* r);
+
+    /**
+    * Helpers for `joinNodes()`, when `l` (resp. `r`) is the taller tree.
+    * Walk down the right (resp. left) spine of the taller tree until the
+    * heights match, hang `k` there and rebalance on the way back up.
+    */
+    AVLNode* joinRight(AVLNode* l, AVLNode* k, AVLNode* r);
+    AVLNode* joinLeft(AVLNode* l, AVLNode* k, AVLNode* r);
+
+    /**
+    * Same as `joinNodes()`, but without a middle node.
+    */
+    AVLNode* concatNodes(AVLNode* l, AVLNode* r);
+
+    /**
+    * Detaches the largest node of `t` into `last`, returns the rest of `t`.
+    */
+    AVLNode* splitLast(AVLNode* t, AVLNode* & last);
+
+    /**
+    * Splits `t` into `lo` (values < val) and `hi` (values > val).
+    * Returns the detached node holding `val`, or `nullptr`.
+    */
+    AVLNode* splitNode(AVLNode* t, int val, AVLNode* & lo, AVLNode* & hi);
+
+    /**
+    * Recursive set operations called by `unionWith()`, `intersectWith()`
+    * and `differenceWith()`. Both arguments are consumed.
+    * `forks` is the number of recursion levels which may still spawn a task.
+    */
+    AVLNode* unionNodes(AVLNode* a, AVLNode* b, int forks);
+    AVLNode* intersectNodes(AVLNode* a, AVLNode* b, int forks);
+    AVLNode* differenceNodes(AVLNode* a, AVLNode* b, int forks);
+
+    /**
+    * Runs `f` and `g`, `f` on a new thread when `parallel` is set.
+    */
+    template<typename F, typename G>
+    static void forkJoin(bool parallel, F f, G g);
+
+    /**
+    * Number of recursion levels of a set operation allowed to fork,
+    * enough to give each of `threads` threads a few tasks, 0 for a
+    * single thread. `threads` = 0 stands for the hardware threads.
+    */
+    static int forkBudget(unsigned threads);
+
+    /**
+    * Recursively builds a balanced tree from the sorted range v[lo, hi).
+    * Nodes are allocated in pre-order, so a search walks through memory
+    * front to back.
+    */
+    AVLNode* buildNodes(const std::vector<int>& v, size_t lo, size_t hi);
+
+    /**
+    * Recursive batch insertion called by `insertBatch()`.
+    * Inserts the sorted range v[lo, hi) into the subtree `node`
+    * and returns the new root of that subtree.
+    */
+    AVLNode* insertSorted(AVLNode* node, const std::vector<int>& v, size_t lo, size_t hi);
+
+    /**
+    * Recursive range scan called by `forEachInRange()`
+    */
+    template<typename F>
+    void rangeNode(AVLNode* node, int lo, int hi, F& fn);
+
+    /**
+    * Deletes every node of the subtree rooted at `node`.
+    */
+    void destroyNode(AVLNode* node);
+
+    /**
+    * Recursive pre-order writer called by `save()`.
+    * Records are gathered in `buf` and flushed to `writer` when it is full.
+    * Returns the number of nodes written.
+    */
+    static uint64_t saveNode(const AVLNode* node, ImageWriter& writer, std::vector<uint32_t>& buf);
+
+    /**
+    * Whether every node of a loaded subtree has the height of its children
+    * plus one and is balanced.
+    */
+    static bool validNode(AVLNode* node);
+
+};
+
+
+template<typename F>
+void AVLTree::forEachInRange(int lo, int hi, F fn) {
+    rangeNode(root, lo, hi, fn);
+}
+
+
+template<typename F>
+void AVLTree::rangeNode(AVLNode* node, int lo, int hi, F& fn) {
+    if(node == nullptr)
+        return;
+
+    // Equal values may sit on either side after rotations
+    if(lo <= node->val)
+        rangeNode(node->left, lo, hi, fn);
+    if(lo <= node->val && node->val <= hi)
+        fn(node->val);
+    if(node->val <= hi)
+        rangeNode(node->right, lo, hi, fn);
+}
+
+
+#endif // AVLTREE_H
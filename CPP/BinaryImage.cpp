@@ -0,0 +1,227 @@
+#include "BinaryImage.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DS_HAVE_MMAP 1
+#define DS_HAVE_FSYNC 1
+#endif
+
+
+Checksum::Checksum() : h(0xcbf29ce484222325ull), pending(0), pendingBytes(0) {
+}
+
+
+void Checksum::mix(uint64_t word) {
+    h ^= word;
+    h *= 0x100000001b3ull;
+    h ^= h >> 29;
+}
+
+
+void Checksum::update(const void* data, size_t n) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+
+    // Complete the word left over by the previous call
+    while(pendingBytes != 0 && n != 0) {
+        pending |= uint64_t(*p++) << (8 * pendingBytes);
+        --n;
+        if(++pendingBytes == 8) {
+            mix(pending);
+            pending = 0;
+            pendingBytes = 0;
+        }
+    }
+
+    for(; n >= 8; n -= 8, p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        mix(word);
+    }
+
+    for(; n != 0; --n) {
+        pending |= uint64_t(*p++) << (8 * pendingBytes++);
+    }
+}
+
+
+uint64_t Checksum::value() const {
+    if(pendingBytes == 0)
+        return h;
+
+    // Same as a final call to mix(), without changing the state
+    uint64_t res = (h ^ pending) * 0x100000001b3ull;
+    return res ^ (res >> 29);
+}
+
+
+/**
+* Checksum of an image, from that of its payload: the header, with its
+* `checksum` zeroed, is folded in last so that `meta` is covered too.
+*/
+static uint64_t imageChecksum(Checksum payload, const ImageHeader& header) {
+    ImageHeader h = header;
+    h.checksum = 0;
+    payload.update(&h, sizeof(h));
+    return payload.value();
+}
+
+
+ImageWriter::ImageWriter(const std::string& path, const char* magic)
+    : path(path), tmpPath(path + ".tmp"), out(tmpPath, std::ios::binary | std::ios::trunc), finished(false) {
+
+    if(!out) {
+        throw std::runtime_error("cannot create " + tmpPath);
+    }
+
+    std::memset(&header, 0, sizeof(header));
+    std::strncpy(header.magic, magic, sizeof(header.magic));
+    header.version = IMAGE_VERSION;
+    header.byteOrder = IMAGE_BYTE_ORDER;
+
+    // Placeholder, rewritten by finish()
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+
+void ImageWriter::write(const void* data, size_t n) {
+    checksum.update(data, n);
+    header.payloadBytes += n;
+    out.write(static_cast<const char*>(data), n);
+}
+
+
+ImageWriter::~ImageWriter() {
+    if(!finished) {
+        out.close();
+        std::remove(tmpPath.c_str());
+    }
+}
+
+
+void ImageWriter::finish(uint64_t count, int64_t meta0, int64_t meta1, int64_t meta2) {
+    header.count = count;
+    header.meta[0] = meta0;
+    header.meta[1] = meta1;
+    header.meta[2] = meta2;
+    header.checksum = imageChecksum(checksum, header);
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if(!out) {
+        throw std::runtime_error("cannot write " + tmpPath);
+    }
+
+#ifdef DS_HAVE_FSYNC
+    // The data must be on disk before the rename is, or a crash could
+    // leave `path` naming an empty file
+    int fd = open(tmpPath.c_str(), O_WRONLY);
+    bool synced = fd >= 0 && fsync(fd) == 0;
+    if(fd >= 0) {
+        close(fd);
+    }
+    if(!synced) {
+        throw std::runtime_error("cannot sync " + tmpPath);
+    }
+#endif
+
+#ifdef _WIN32
+    // rename() does not replace an existing file there
+    std::remove(path.c_str());
+#endif
+    if(std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("cannot rename " + tmpPath + " to " + path);
+    }
+    finished = true;
+}
+
+
+MappedFile::MappedFile(const std::string& path) : base(nullptr), length(0), mapped(false) {
+#ifdef DS_HAVE_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) == 0 && st.st_size > 0) {
+        length = st.st_size;
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p != MAP_FAILED) {
+            // Images are read front to back
+            madvise(p, length, MADV_SEQUENTIAL);
+            base = static_cast<const char*>(p);
+            mapped = true;
+        }
+    }
+    close(fd);
+    if(mapped || length == 0)
+        return;
+#endif
+
+    std::ifstream in(path, std::ios::binary);
+    if(!in) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    base = buffer.data();
+    length = buffer.size();
+}
+
+
+MappedFile::~MappedFile() {
+#ifdef DS_HAVE_MMAP
+    if(mapped) {
+        munmap(const_cast<char*>(base), length);
+    }
+#endif
+}
+
+
+const char* MappedFile::data() const {
+    return base;
+}
+
+
+size_t MappedFile::size() const {
+    return length;
+}
+
+
+const char* openImage(const MappedFile& file, const char* magic, size_t recordSize, ImageHeader& header) {
+    if(file.size() < sizeof(ImageHeader)) {
+        throw std::runtime_error("image too short");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if(std::strncmp(header.magic, magic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(std::string("not an image of ") + magic);
+    }
+    if(header.byteOrder != IMAGE_BYTE_ORDER) {
+        throw std::runtime_error("image written with another byte order");
+    }
+    if(header.version != IMAGE_VERSION) {
+        throw std::runtime_error("unsupported image version " + std::to_string(header.version));
+    }
+    if(header.payloadBytes != file.size() - sizeof(ImageHeader) ||
+        header.payloadBytes / recordSize != header.count ||
+        header.payloadBytes % recordSize != 0) {
+        throw std::runtime_error("image truncated");
+    }
+
+    const char* payload = file.data() + sizeof(ImageHeader);
+    Checksum checksum;
+    checksum.update(payload, header.payloadBytes);
+    if(imageChecksum(checksum, header) != header.checksum) {
+        throw std::runtime_error("image checksum mismatch");
+    }
+    return payload;
+}
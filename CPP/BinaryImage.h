@@ -0,0 +1,164 @@
+#ifndef BINARYIMAGE_H
+#define BINARYIMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+* Binary images used to save a structure and load it back quickly,
+* e.g. `SegmentTree::save()` / `SegmentTree::load()`.
+*
+* An image is a 64 byte `ImageHeader` followed by the payload, an array
+* of fixed size records written in the byte order of the machine.
+* Loading maps the file into memory, so the payload is read straight
+* from the page cache.
+*/
+
+const uint32_t IMAGE_VERSION = 2;
+
+/**
+* Written as a native uint32_t, reads back differently on a machine
+* with the other byte order.
+*/
+const uint32_t IMAGE_BYTE_ORDER = 0x01020304;
+
+
+struct ImageHeader {
+    /**
+    * Kind of structure, e.g. "SEGTREE", zero padded
+    */
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+
+    /**
+    * Number of records in the payload, and its size in bytes
+    */
+    uint64_t count;
+    uint64_t payloadBytes;
+
+    /**
+    * `Checksum` of the payload followed by this header, with this
+    * field set to 0
+    */
+    uint64_t checksum;
+
+    /**
+    * Free for each structure, e.g. the number of leaves
+    */
+    int64_t meta[3];
+};
+
+static_assert(sizeof(ImageHeader) == 64, "ImageHeader must stay 64 bytes");
+
+
+/**
+* 64 bit checksum, fed 8 bytes at a time.
+* It detects truncated and corrupted files, it is not a secure hash.
+*/
+class Checksum {
+public:
+    Checksum();
+
+    /**
+    * Adds `n` bytes, which may be split across calls anywhere.
+    */
+    void update(const void* data, size_t n);
+
+    uint64_t value() const;
+
+private:
+    uint64_t h;
+
+    /**
+    * Bytes of the last, incomplete word
+    */
+    uint64_t pending;
+    int pendingBytes;
+
+    void mix(uint64_t word);
+};
+
+
+/**
+* Writes an image to `path`.
+* The image goes to a temporary file first, which replaces `path` in
+* `finish()`, so a crash while saving never leaves a half written image.
+* The temporary file is removed if the writer is destroyed unfinished.
+*/
+class ImageWriter {
+public:
+    /**
+    * Throws `std::runtime_error` if the file cannot be created
+    */
+    ImageWriter(const std::string& path, const char* magic);
+    ~ImageWriter();
+
+    ImageWriter(const ImageWriter&) = delete;
+    ImageWriter& operator=(const ImageWriter&) = delete;
+
+    /**
+    * Appends `n` bytes to the payload
+    */
+    void write(const void* data, size_t n);
+
+    /**
+    * Writes the header, with `count` records and the given metadata,
+    * and moves the image to its final path.
+    * Throws `std::runtime_error` if it cannot, leaving `path` untouched.
+    */
+    void finish(uint64_t count, int64_t meta0 = 0, int64_t meta1 = 0, int64_t meta2 = 0);
+
+private:
+    std::string path;
+    std::string tmpPath;
+    std::ofstream out;
+    ImageHeader header;
+    Checksum checksum;
+    bool finished;
+};
+
+
+/**
+* A read-only view of a whole file.
+* The file is mapped with mmap where available, read into memory otherwise.
+*/
+class MappedFile {
+public:
+    /**
+    * Throws `std::runtime_error` if the file cannot be opened
+    */
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const;
+    size_t size() const;
+
+private:
+    const char* base;
+    size_t length;
+
+    /**
+    * Holds the file when it could not be mapped
+    */
+    std::vector<char> buffer;
+    bool mapped;
+};
+
+
+/**
+* Checks that `file` is an intact image of kind `magic`, whose records
+* are `recordSize` bytes, and fills in `header`.
+* Returns a pointer to the first record.
+* Throws `std::runtime_error` naming the first problem found.
+*/
+const char* openImage(const MappedFile& file, const char* magic, size_t recordSize, ImageHeader& header);
+
+
+#endif // BINARYIMAGE_H
@@ -0,0 +1,351 @@
+#include "CompactAVLTree.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+CompactAVLNode::CompactAVLNode(int v) : val(v), left(NIL), right(NIL) {
+}
+
+
+uint32_t CompactAVLNode::getLeft() const {
+    return left & INDEX_MASK;
+}
+
+
+uint32_t CompactAVLNode::getRight() const {
+    return right & INDEX_MASK;
+}
+
+
+int CompactAVLNode::getHeight() const {
+    return ((left >> INDEX_BITS) << 3) | (right >> INDEX_BITS);
+}
+
+
+void CompactAVLNode::setLeft(uint32_t i) {
+    left = (left & ~INDEX_MASK) | i;
+}
+
+
+void CompactAVLNode::setRight(uint32_t i) {
+    right = (right & ~INDEX_MASK) | i;
+}
+
+
+void CompactAVLNode::setHeight(int h) {
+    left = (left & INDEX_MASK) | ((uint32_t)(h >> 3) << INDEX_BITS);
+    right = (right & INDEX_MASK) | ((uint32_t)(h & 7) << INDEX_BITS);
+}
+
+
+CompactAVLTree::CompactAVLTree() : root(NIL), freeList(NIL), count(0) {
+}
+
+
+int CompactAVLTree::height(uint32_t i) const {
+    if(i == NIL) {
+        return -1;
+    }
+    return nodes[i].getHeight();
+}
+
+
+void CompactAVLTree::updateHeight(uint32_t i) {
+    CompactAVLNode& n = nodes[i];
+    n.setHeight(std::max(height(n.getLeft()), height(n.getRight())) + 1);
+}
+
+
+uint32_t CompactAVLTree::newNode(int val) {
+    uint32_t i;
+    if(freeList != NIL) {
+        i = freeList;
+        freeList = nodes[i].getLeft();
+        nodes[i] = CompactAVLNode(val);
+    } else {
+        if(nodes.size() >= NIL) {
+            throw std::length_error("CompactAVLTree is full");
+        }
+        i = nodes.size();
+        nodes.push_back(CompactAVLNode(val));
+    }
+    ++count;
+    return i;
+}
+
+
+void CompactAVLTree::freeNode(uint32_t i) {
+    nodes[i].setLeft(freeList);
+    freeList = i;
+    --count;
+}
+
+
+void CompactAVLTree::insert(int val) {
+    root = insertNode(root, val);
+}
+
+
+uint32_t CompactAVLTree::insertNode(uint32_t i, int val) {
+    if(i == NIL) {
+        return newNode(val);
+    }
+
+    if(val < nodes[i].val) {
+        uint32_t l = insertNode(nodes[i].getLeft(), val);
+        nodes[i].setLeft(l);
+    } else {
+        uint32_t r = insertNode(nodes[i].getRight(), val);
+        nodes[i].setRight(r);
+    }
+    return rebalance(i);
+}
+
+
+bool CompactAVLTree::remove(int val) {
+    bool res = false;
+    root = removeNode(root, val, res);
+    return res;
+}
+
+
+uint32_t CompactAVLTree::removeNode(uint32_t i, int val, bool& res) {
+    if(i == NIL) {
+        return NIL;
+    }
+
+    if(val < nodes[i].val) {
+        uint32_t l = removeNode(nodes[i].getLeft(), val, res);
+        nodes[i].setLeft(l);
+    } else if (val > nodes[i].val) {
+        uint32_t r = removeNode(nodes[i].getRight(), val, res);
+        nodes[i].setRight(r);
+    } else {
+        // Found node, now delete it
+
+        res = true;
+        uint32_t l = nodes[i].getLeft();
+        uint32_t r = nodes[i].getRight();
+        if(l == NIL || r == NIL) {
+            // Leaf or one child, the child takes its place
+            freeNode(i);
+            return (l != NIL) ? l : r;
+        }
+
+        // Two children, replace with the inorder predecessor
+        uint32_t find = l;
+        while(nodes[find].getRight() != NIL) {
+            find = nodes[find].getRight();
+        }
+        nodes[i].val = nodes[find].val;
+
+        bool removed = false;
+        l = removeNode(l, nodes[i].val, removed);
+        nodes[i].setLeft(l);
+    }
+    return rebalance(i);
+}
+
+
+uint32_t CompactAVLTree::rotateLL(uint32_t i) {
+    uint32_t temp = nodes[i].getLeft();
+    nodes[i].setLeft(nodes[temp].getRight());
+    nodes[temp].setRight(i);
+
+    updateHeight(i);
+    updateHeight(temp);
+    return temp;
+}
+
+
+uint32_t CompactAVLTree::rotateRR(uint32_t i) {
+    uint32_t temp = nodes[i].getRight();
+    nodes[i].setRight(nodes[temp].getLeft());
+    nodes[temp].setLeft(i);
+
+    updateHeight(i);
+    updateHeight(temp);
+    return temp;
+}
+
+
+uint32_t CompactAVLTree::rebalance(uint32_t i) {
+    uint32_t l = nodes[i].getLeft();
+    uint32_t r = nodes[i].getRight();
+
+    int hdf = height(r) - height(l);
+    if (hdf > 1) {
+        // Rebalance right heavy
+
+        if(height(nodes[r].getRight()) < height(nodes[r].getLeft())) {
+            // RL
+            nodes[i].setRight(rotateLL(r));
+        }
+        return rotateRR(i);
+    } else if (hdf < -1) {
+        // Rebalance left heavy
+
+        if(height(nodes[l].getLeft()) < height(nodes[l].getRight())) {
+            // LR
+            nodes[i].setLeft(rotateRR(l));
+        }
+        return rotateLL(i);
+    }
+
+    updateHeight(i);
+    return i;
+}
+
+
+bool CompactAVLTree::search(int val) const {
+    uint32_t i = root;
+    while(i != NIL) {
+        const CompactAVLNode& n = nodes[i];
+        if(val < n.val) {
+            i = n.getLeft();
+        } else if (val > n.val) {
+            i = n.getRight();
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void CompactAVLTree::buildFromSorted(const std::vector<int>& v, Layout layout) {
+    if(v.size() >= NIL) {
+        throw std::length_error("CompactAVLTree is full");
+    }
+
+    nodes.clear();
+    nodes.reserve(v.size());
+    freeList = NIL;
+    count = 0;
+
+    root = buildNodes(v, 0, v.size());
+    if(layout != Layout::PREORDER) {
+        relayout(layout);
+    }
+}
+
+
+uint32_t CompactAVLTree::buildNodes(const std::vector<int>& v, size_t lo, size_t hi) {
+    if(lo == hi) {
+        return NIL;
+    }
+
+    size_t mid = lo + (hi - lo) / 2;
+    uint32_t i = newNode(v[mid]);
+    uint32_t l = buildNodes(v, lo, mid);
+    uint32_t r = buildNodes(v, mid + 1, hi);
+    nodes[i].setLeft(l);
+    nodes[i].setRight(r);
+    updateHeight(i);
+    return i;
+}
+
+
+void CompactAVLTree::relayout(Layout layout) {
+    std::vector<uint32_t> order;
+    order.reserve(count);
+
+    if(root != NIL) {
+        if(layout == Layout::BFS) {
+            // `order` doubles as the queue
+            order.push_back(root);
+            for(size_t q = 0; q < order.size(); ++q) {
+                const CompactAVLNode& n = nodes[order[q]];
+                if(n.getLeft() != NIL)
+                    order.push_back(n.getLeft());
+                if(n.getRight() != NIL)
+                    order.push_back(n.getRight());
+            }
+        } else if (layout == Layout::VEB) {
+            vebOrder(root, height(root) + 1, order);
+        } else {
+            // Pre-order, with an explicit stack
+            std::vector<uint32_t> stack(1, root);
+            while(!stack.empty()) {
+                uint32_t i = stack.back();
+                stack.pop_back();
+                order.push_back(i);
+                if(nodes[i].getRight() != NIL)
+                    stack.push_back(nodes[i].getRight());
+                if(nodes[i].getLeft() != NIL)
+                    stack.push_back(nodes[i].getLeft());
+            }
+        }
+    }
+
+    // remap[old index] = new index
+    std::vector<uint32_t> remap(nodes.size(), NIL);
+    for(size_t k = 0; k < order.size(); ++k) {
+        remap[order[k]] = k;
+    }
+
+    std::vector<CompactAVLNode> packed;
+    packed.reserve(order.size());
+    for(uint32_t old : order) {
+        CompactAVLNode n = nodes[old];
+        if(n.getLeft() != NIL)
+            n.setLeft(remap[n.getLeft()]);
+        if(n.getRight() != NIL)
+            n.setRight(remap[n.getRight()]);
+        packed.push_back(n);
+    }
+
+    nodes.swap(packed);
+    root = (root == NIL) ? NIL : remap[root];
+    freeList = NIL;
+}
+
+
+void CompactAVLTree::vebOrder(uint32_t i, int levels, std::vector<uint32_t>& order) const {
+    if(i == NIL) {
+        return;
+    }
+    if(levels == 1) {
+        order.push_back(i);
+        return;
+    }
+
+    int top = levels / 2;
+    int bottom = levels - top;
+    vebOrder(i, top, order);
+
+    std::vector<uint32_t> below;
+    collectDepth(i, top, below);
+    for(uint32_t b : below) {
+        vebOrder(b, bottom, order);
+    }
+}
+
+
+void CompactAVLTree::collectDepth(uint32_t i, int depth, std::vector<uint32_t>& out) const {
+    if(i == NIL) {
+        return;
+    }
+    if(depth == 0) {
+        out.push_back(i);
+        return;
+    }
+    collectDepth(nodes[i].getLeft(), depth - 1, out);
+    collectDepth(nodes[i].getRight(), depth - 1, out);
+}
+
+
+const CompactAVLNode& CompactAVLTree::at(uint32_t i) const {
+    return nodes.at(i);
+}
+
+
+size_t CompactAVLTree::size() const {
+    return count;
+}
+
+
+size_t CompactAVLTree::memoryUsage() const {
+    return sizeof(*this) + nodes.capacity() * sizeof(CompactAVLNode);
+}
@@ -0,0 +1,189 @@
+#ifndef COMPACTAVLTREE_H
+#define COMPACTAVLTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+* Links are 32-bit indices into `CompactAVLTree::nodes`.
+* The low 29 bits of each link hold the index and the top 3 bits of the
+* two links together hold the 6 bit height of the node, so a node
+* takes 12 bytes instead of the 24 bytes of a pointer based `AVLNode`.
+*
+* 29 bits address ~5 * 10^8 nodes, 6 bits store heights up to 63,
+* while an AVL tree of 2^29 nodes is at most 42 high.
+*/
+const int INDEX_BITS = 29;
+const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+
+/**
+* Index used as `nullptr`
+*/
+const uint32_t NIL = INDEX_MASK;
+
+
+class CompactAVLNode {
+public:
+    int val;
+
+    /**
+    * Constructor
+    */
+    explicit CompactAVLNode(int v);
+
+    uint32_t getLeft() const;
+    uint32_t getRight() const;
+    int getHeight() const;
+
+    void setLeft(uint32_t i);
+    void setRight(uint32_t i);
+    void setHeight(int h);
+
+private:
+    uint32_t left;   // high 3 bits of height | left index
+    uint32_t right;  // low 3 bits of height  | right index
+};
+
+
+/**
+* Order of the nodes inside `CompactAVLTree::nodes`, see `relayout()`
+*/
+enum class Layout {
+    PREORDER,  // order of `buildFromSorted()`, no relayout
+    BFS,       // level by level, the top levels share a few cache lines
+    VEB        // van Emde Boas, every subtree of h levels is contiguous
+};
+
+
+class CompactAVLTree {
+public:
+    /**
+    * Index of the root node, `NIL` when the tree is empty
+    */
+    uint32_t root;
+
+    /**
+    * Constructor
+    */
+    CompactAVLTree();
+
+    /**
+    * Insert the given value into the tree
+    * Throws `std::length_error` when the tree is full.
+    */
+    void insert(int val);
+
+    /**
+    * Deletes the given value from the tree
+    * Returns a bool to denote success of deletion
+    */
+    bool remove(int val);
+
+    /**
+    * Returns whether `val` is present in the tree
+    */
+    bool search(int val) const;
+
+    /**
+    * Replaces the contents of the tree with the values of `v`,
+    * which must be sorted in ascending order, in O(n).
+    * The nodes are then laid out in the given order.
+    */
+    void buildFromSorted(const std::vector<int>& v, Layout layout = Layout::VEB);
+
+    /**
+    * Moves every node to a new position in `nodes`, following `layout`.
+    * Also drops the slots of removed nodes. Runs in O(n log log n).
+    */
+    void relayout(Layout layout);
+
+    /**
+    * Node at index `i`
+    */
+    const CompactAVLNode& at(uint32_t i) const;
+
+    /**
+    * Number of values in the tree
+    */
+    size_t size() const;
+
+    /**
+    * Bytes held by the tree, including free slots
+    */
+    size_t memoryUsage() const;
+
+private:
+    /**
+    * Contiguous node storage, links are indices into it
+    */
+    std::vector<CompactAVLNode> nodes;
+
+    /**
+    * Head of the list of free slots, chained through their left link
+    */
+    uint32_t freeList;
+
+    size_t count;
+
+    int height(uint32_t i) const;
+
+    /**
+    * Recomputes the height of `i` from its children
+    */
+    void updateHeight(uint32_t i);
+
+    /**
+    * Returns the index of a new node holding `val`,
+    * reusing a free slot when there is one.
+    */
+    uint32_t newNode(int val);
+
+    /**
+    * Puts the slot `i` back on the free list
+    */
+    void freeNode(uint32_t i);
+
+    /**
+    * Recursive functions called by `insert()` and `remove()`.
+    * They return the new root of the subtree.
+    *
+    * Nothing holds a reference into `nodes` across the recursion,
+    * as `newNode()` may reallocate it.
+    */
+    uint32_t insertNode(uint32_t i, int val);
+    uint32_t removeNode(uint32_t i, int val, bool& res);
+
+    /**
+    * Same rotations as `AVLTree::rotateLL` and `AVLTree::rotateRR`.
+    * Return the new root of the subtree.
+    */
+    uint32_t rotateLL(uint32_t i);
+    uint32_t rotateRR(uint32_t i);
+
+    /**
+    * Restores the AVL property at `i`, whose subtrees may differ in
+    * height by at most 2. Returns the new root of the subtree.
+    */
+    uint32_t rebalance(uint32_t i);
+
+    /**
+    * Recursively builds a balanced tree from the sorted range v[lo, hi)
+    */
+    uint32_t buildNodes(const std::vector<int>& v, size_t lo, size_t hi);
+
+    /**
+    * Appends to `order` the nodes of the top `levels` levels of the
+    * subtree `i` in van Emde Boas order: first the top half of the levels,
+    * then every subtree hanging below it, each laid out recursively.
+    */
+    void vebOrder(uint32_t i, int levels, std::vector<uint32_t>& order) const;
+
+    /**
+    * Appends to `out` the nodes `depth` levels below `i`, left to right
+    */
+    void collectDepth(uint32_t i, int depth, std::vector<uint32_t>& out) const;
+};
+
+
+#endif // COMPACTAVLTREE_H
@@ -0,0 +1,327 @@
+#include "ConcurrentAVLTree.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+
+ConcurrentAVLNode::ConcurrentAVLNode(int v)
+    : val(v), present(true), version(0), left(nullptr), right(nullptr), height(0) {
+}
+
+
+std::atomic<ConcurrentAVLNode*>& ConcurrentAVLNode::child(int dir) {
+    return dir < 0 ? left : right;
+}
+
+
+int height(ConcurrentAVLNode* node) {
+    if(node) {
+        return node->height;
+    } else {
+        return -1;
+    }
+}
+
+
+EpochReclaimer::EpochReclaimer() : globalEpoch(1) {
+    for(Slot& s : slots) {
+        s.epoch.store(INACTIVE);
+    }
+}
+
+
+EpochReclaimer::~EpochReclaimer() {
+    for(auto& p : limbo) {
+        delete p.second;
+    }
+}
+
+
+int EpochReclaimer::enter() {
+    // Start from the slot this thread took last time, so that readers
+    // do not all compete for the first ones
+    thread_local int hint = int(std::hash<std::thread::id>()(std::this_thread::get_id()) % READER_SLOTS);
+
+    while(true) {
+        for(int k = 0; k < READER_SLOTS; ++k) {
+            int i = (hint + k) % READER_SLOTS;
+            uint64_t expected = INACTIVE;
+            if(slots[i].epoch.load() == INACTIVE &&
+                slots[i].epoch.compare_exchange_strong(expected, globalEpoch.load())) {
+                hint = i;
+                return i;
+            }
+        }
+        // Every slot is in use
+        std::this_thread::yield();
+    }
+}
+
+
+void EpochReclaimer::leave(int slot) {
+    slots[slot].epoch.store(INACTIVE);
+}
+
+
+void EpochReclaimer::retire(ConcurrentAVLNode* node) {
+    limbo.push_back(std::make_pair(globalEpoch.load(), node));
+    if(limbo.size() % RECLAIM_BATCH == 0) {
+        reclaim();
+    }
+}
+
+
+void EpochReclaimer::reclaim() {
+    uint64_t e = globalEpoch.load();
+    bool advance = true;
+    for(Slot& s : slots) {
+        uint64_t local = s.epoch.load();
+        if(local != INACTIVE && local != e) {
+            advance = false;
+            break;
+        }
+    }
+    if(advance) {
+        globalEpoch.store(++e);
+    }
+
+    size_t freed = 0;
+    while(freed < limbo.size() && limbo[freed].first + 2 <= e) {
+        delete limbo[freed].second;
+        ++freed;
+    }
+    limbo.erase(limbo.begin(), limbo.begin() + freed);
+}
+
+
+ConcurrentAVLTree::ConcurrentAVLTree() : rootHolder(0) {
+    rootHolder.present.store(false);
+}
+
+
+ConcurrentAVLTree::~ConcurrentAVLTree() {
+    destroyNode(rootHolder.right.load());
+}
+
+
+ConcurrentAVLNode* ConcurrentAVLTree::getRoot() {
+    return rootHolder.right.load();
+}
+
+
+bool ConcurrentAVLTree::search(int val) {
+    int slot = reclaimer.enter();
+    Result r = attemptSearch(val, &rootHolder, 1, rootHolder.version.load());
+    reclaimer.leave(slot);
+
+    // `rootHolder` never changes, so there is nothing left to retry
+    return r == PRESENT;
+}
+
+
+ConcurrentAVLTree::Result ConcurrentAVLTree::attemptSearch(
+    int val,
+    ConcurrentAVLNode* node,
+    int dir,
+    uint64_t nodeV
+    ) {
+
+    while(true) {
+        ConcurrentAVLNode* child = node->child(dir).load();
+
+        // `child` is only meaningful if `node` did not move since we entered it
+        if(node->version.load() != nodeV)
+            return RETRY;
+        if(child == nullptr)
+            return ABSENT;
+        if(val == child->val)
+            return child->present.load() ? PRESENT : ABSENT;
+
+        int nextDir = (val < child->val) ? -1 : 1;
+        uint64_t childV = child->version.load();
+
+        if(childV & SHRINKING) {
+            waitUntilNotShrinking(child);
+        } else if (!(childV & UNLINKED) && child == node->child(dir).load()) {
+            if(node->version.load() != nodeV)
+                return RETRY;
+
+            // Hand over hand: `child` is now validated against `node`
+            Result r = attemptSearch(val, child, nextDir, childV);
+            if(r != RETRY)
+                return r;
+        }
+        // Otherwise re-read the child of `node`
+    }
+}
+
+
+void ConcurrentAVLTree::waitUntilNotShrinking(ConcurrentAVLNode* node) {
+    while(node->version.load() & SHRINKING) {
+        std::this_thread::yield();
+    }
+}
+
+
+bool ConcurrentAVLTree::insert(int val) {
+    std::lock_guard<std::mutex> guard(writeLock);
+    return insertNode(rootHolder.right, val);
+}
+
+
+bool ConcurrentAVLTree::insertNode(std::atomic<ConcurrentAVLNode*>& slot, int val) {
+    ConcurrentAVLNode* node = slot.load();
+
+    if(node == nullptr) {
+        slot.store(new ConcurrentAVLNode(val));
+        return true;
+    }
+
+    bool res;
+    if(val < node->val) {
+        res = insertNode(node->left, val);
+    } else if (val > node->val) {
+        res = insertNode(node->right, val);
+    } else {
+        // Revive the routing node, if it is one
+        return !node->present.exchange(true);
+    }
+
+    if(res) {
+        rebalance(slot);
+    }
+    return res;
+}
+
+
+bool ConcurrentAVLTree::remove(int val) {
+    std::lock_guard<std::mutex> guard(writeLock);
+    return removeNode(rootHolder.right, val);
+}
+
+
+bool ConcurrentAVLTree::removeNode(std::atomic<ConcurrentAVLNode*>& slot, int val) {
+    ConcurrentAVLNode* node = slot.load();
+    if(node == nullptr)
+        return false;
+
+    bool res;
+    if(val < node->val) {
+        res = removeNode(node->left, val);
+    } else if (val > node->val) {
+        res = removeNode(node->right, val);
+    } else {
+        // Found node, now delete its value
+        res = node->present.exchange(false);
+    }
+
+    if(!res)
+        return false;
+
+    if(!node->present.load() &&
+        (node->left.load() == nullptr || node->right.load() == nullptr)) {
+        // The removed value, or a routing node left by an earlier removal.
+        // The child subtree is already balanced, our parent rebalances.
+        unlink(slot, node);
+    } else {
+        rebalance(slot);
+    }
+    return true;
+}
+
+
+void ConcurrentAVLTree::unlink(std::atomic<ConcurrentAVLNode*>& slot, ConcurrentAVLNode* node) {
+    ConcurrentAVLNode* child = node->left.load();
+    if(child == nullptr) {
+        child = node->right.load();
+    }
+
+    // Readers inside `node` may carry on, its child is still reachable
+    slot.store(child);
+    node->version.store(node->version.load() | UNLINKED);
+    reclaimer.retire(node);
+}
+
+
+void ConcurrentAVLTree::rebalance(std::atomic<ConcurrentAVLNode*>& slot) {
+    ConcurrentAVLNode* node = slot.load();
+    ConcurrentAVLNode* l = node->left.load();
+    ConcurrentAVLNode* r = node->right.load();
+
+    int hdf = height(r) - height(l);
+    if (hdf > 1) {
+        // Rebalance right heavy
+
+        if(height(r->right.load()) >= height(r->left.load())) {
+            // RR
+            rotateRR(slot);
+        } else {
+            // RL
+            rotateLL(node->right);
+            rotateRR(slot);
+        }
+    } else if (hdf < -1) {
+        // Rebalance left heavy
+
+        if(height(l->left.load()) >= height(l->right.load())) {
+            // LL
+            rotateLL(slot);
+        } else {
+            // LR
+            rotateRR(node->left);
+            rotateLL(slot);
+        }
+    } else {
+        node->height = std::max(height(l), height(r)) + 1;
+    }
+}
+
+
+void ConcurrentAVLTree::rotateLL(std::atomic<ConcurrentAVLNode*>& slot) {
+    ConcurrentAVLNode* node = slot.load();
+    ConcurrentAVLNode* temp = node->left.load();
+    ConcurrentAVLNode* t2 = temp->right.load();
+
+    // `node` loses `temp` and its left subtree
+    uint64_t v = node->version.load();
+    node->version.store(v | SHRINKING);
+
+    node->left.store(t2);
+    temp->right.store(node);
+
+    node->height = 1 + std::max(height(node->left.load()), height(node->right.load()));
+    temp->height = 1 + std::max(height(temp->left.load()), height(temp->right.load()));
+
+    slot.store(temp);
+    node->version.store(v + VERSION_STEP);
+}
+
+
+void ConcurrentAVLTree::rotateRR(std::atomic<ConcurrentAVLNode*>& slot) {
+    ConcurrentAVLNode* node = slot.load();
+    ConcurrentAVLNode* temp = node->right.load();
+    ConcurrentAVLNode* t2 = temp->left.load();
+
+    // `node` loses `temp` and its right subtree
+    uint64_t v = node->version.load();
+    node->version.store(v | SHRINKING);
+
+    node->right.store(t2);
+    temp->left.store(node);
+
+    node->height = 1 + std::max(height(node->left.load()), height(node->right.load()));
+    temp->height = 1 + std::max(height(temp->left.load()), height(temp->right.load()));
+
+    slot.store(temp);
+    node->version.store(v + VERSION_STEP);
+}
+
+
+void ConcurrentAVLTree::destroyNode(ConcurrentAVLNode* node) {
+    if(node != nullptr) {
+        destroyNode(node->left.load());
+        destroyNode(node->right.load());
+        delete node;
+    }
+}
@@ -0,0 +1,229 @@
+#ifndef CONCURRENTAVLTREE_H
+#define CONCURRENTAVLTREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+* Bits of `ConcurrentAVLNode::version`
+*   SHRINKING : set while a rotation moves the node down, i.e. while the
+*               range of values reachable through it shrinks
+*   UNLINKED  : set once the node has been removed from the tree
+* The remaining bits count the rotations the node went through.
+*/
+const uint64_t SHRINKING = 1;
+const uint64_t UNLINKED = 2;
+const uint64_t VERSION_STEP = 4;
+
+
+class ConcurrentAVLNode {
+public:
+    /**
+    * Never changes, so readers may compare against it without validation
+    */
+    const int val;
+
+    /**
+    * `false` for a routing node, i.e. a removed value whose node had two
+    * children and therefore could not be unlinked right away.
+    */
+    std::atomic<bool> present;
+
+    std::atomic<uint64_t> version;
+    std::atomic<ConcurrentAVLNode*> left;
+    std::atomic<ConcurrentAVLNode*> right;
+
+    /**
+    * Only read and written by the writer
+    */
+    int height;
+
+    /**
+    * Constructor
+    */
+    explicit ConcurrentAVLNode(int v);
+
+    /**
+    * Left child for `dir < 0`, right child otherwise
+    */
+    std::atomic<ConcurrentAVLNode*>& child(int dir);
+};
+
+
+int height(ConcurrentAVLNode* node);
+
+
+/**
+* Epoch based reclamation of the nodes unlinked by the writer.
+*
+* A reader takes a free slot for the duration of an operation and
+* publishes the global epoch in it. An unlinked node is tagged with the
+* epoch it was retired in and freed once the global epoch moved two steps
+* past it, which only happens after every reader active at the time has
+* finished.
+*/
+class EpochReclaimer {
+public:
+    /**
+    * Number of slots, i.e. of searches running at the same time.
+    * Past that, a reader waits in `enter()` for a slot to be released.
+    */
+    static const int READER_SLOTS = 128;
+
+    EpochReclaimer();
+
+    /**
+    * Frees every retired node. No reader may be active.
+    */
+    ~EpochReclaimer();
+
+    /**
+    * Marks the calling thread as reading, returns the slot it took
+    * to be handed back to `leave()` once done reading.
+    */
+    int enter();
+    void leave(int slot);
+
+    /**
+    * Hands an unlinked node over for deletion. Writer only.
+    */
+    void retire(ConcurrentAVLNode* node);
+
+private:
+    static const uint64_t INACTIVE = 0;
+
+    /**
+    * Retired nodes between two attempts to advance the epoch
+    */
+    static const size_t RECLAIM_BATCH = 64;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch;
+    };
+
+    std::atomic<uint64_t> globalEpoch;
+    Slot slots[READER_SLOTS];
+
+    /**
+    * Pairs of (retire epoch, node), in increasing epoch order
+    */
+    std::vector<std::pair<uint64_t, ConcurrentAVLNode*>> limbo;
+
+    /**
+    * Moves the global epoch forward if every active reader has seen it,
+    * then frees the nodes no reader can reach anymore.
+    */
+    void reclaim();
+};
+
+
+/**
+* AVL tree based ordered set which can be searched while it is updated.
+*
+* Readers take no lock. They walk down hand over hand and validate the
+* version of every node they leave, as in the optimistic AVL tree of
+* Bronson et al. (PPoPP 2010). A rotation flags the node it moves down as
+* SHRINKING until the new parent link is published, so a reader which
+* crossed it retries from the last node still valid. Values never move
+* between nodes: a node with two children is turned into a routing node
+* when its value is removed, and unlinked by a later removal passing
+* through it once it has a single child.
+*
+* Writers are serialized by a mutex, as updates come from one thread
+* in practice and the rebalancing needs the whole path anyway.
+*/
+class ConcurrentAVLTree {
+public:
+    /**
+    * Constructor
+    */
+    ConcurrentAVLTree();
+
+    /**
+    * Frees every node. No other thread may use the tree anymore.
+    */
+    ~ConcurrentAVLTree();
+
+    ConcurrentAVLTree(const ConcurrentAVLTree&) = delete;
+    ConcurrentAVLTree& operator=(const ConcurrentAVLTree&) = delete;
+
+    /**
+    * Inserts the given value, returns `false` if it was already present
+    */
+    bool insert(int val);
+
+    /**
+    * Deletes the given value from the tree
+    * Returns a bool to denote success of deletion
+    */
+    bool remove(int val);
+
+    /**
+    * Returns whether `val` is present. Takes no lock, it only waits
+    * for a rotation in progress on the node it is about to enter.
+    */
+    bool search(int val);
+
+    /**
+    * Root of the tree, for single threaded inspection
+    */
+    ConcurrentAVLNode* getRoot();
+
+private:
+    /**
+    * Holds the root as its right child, so the root has a parent slot
+    * like every other node. It is never rotated.
+    */
+    ConcurrentAVLNode rootHolder;
+
+    std::mutex writeLock;
+    EpochReclaimer reclaimer;
+
+    enum Result { ABSENT, PRESENT, RETRY };
+
+    /**
+    * Searches `val` below `node`, coming from its child in direction `dir`.
+    * `nodeV` is the version of `node` seen when the reader entered it.
+    * Returns RETRY when `node` changed, so the caller must re-read it.
+    */
+    Result attemptSearch(int val, ConcurrentAVLNode* node, int dir, uint64_t nodeV);
+
+    /**
+    * Spins until the rotation moving `node` down is over
+    */
+    void waitUntilNotShrinking(ConcurrentAVLNode* node);
+
+    /**
+    * Recursive functions called by `insert()` and `remove()`.
+    * `slot` is the parent's link to the current subtree.
+    */
+    bool insertNode(std::atomic<ConcurrentAVLNode*>& slot, int val);
+    bool removeNode(std::atomic<ConcurrentAVLNode*>& slot, int val);
+
+    /**
+    * Replaces `node`, which has at most one child, by that child
+    * and retires it.
+    */
+    void unlink(std::atomic<ConcurrentAVLNode*>& slot, ConcurrentAVLNode* node);
+
+    /**
+    * Same as `AVLTree::rebalance`, `rotateLL` and `rotateRR`, working on
+    * the subtree hanging from `slot`. The rotations flag the node moving
+    * down until the new subtree root is published in `slot`.
+    */
+    void rebalance(std::atomic<ConcurrentAVLNode*>& slot);
+    void rotateLL(std::atomic<ConcurrentAVLNode*>& slot);
+    void rotateRR(std::atomic<ConcurrentAVLNode*>& slot);
+
+    /**
+    * Deletes every node of the subtree rooted at `node`.
+    */
+    void destroyNode(ConcurrentAVLNode* node);
+};
+
+
+#endif // CONCURRENTAVLTREE_H
@@ -0,0 +1,136 @@
+#include "Instrumentation.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+
+Instrumentation::Slot Instrumentation::counters[Instrumentation::COUNTER_COUNT] = {};
+
+int Instrumentation::perfFd = -1;
+
+
+uint64_t Instrumentation::Snapshot::operator[](Counter c) const {
+    return values[c];
+}
+
+
+std::ostream& operator<<(std::ostream& out, const Instrumentation::Snapshot& s) {
+    for(int c = 0; c < Instrumentation::COUNTER_COUNT; ++c) {
+        out << Instrumentation::name(Instrumentation::Counter(c)) << " " << s.values[c] << "\n";
+    }
+    if(s.hasCacheMisses) {
+        out << "cache_misses " << s.cacheMisses << "\n";
+    }
+    return out;
+}
+
+
+bool Instrumentation::enabled() {
+#ifdef DS_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+const char* Instrumentation::name(Counter c) {
+    static const char* names[COUNTER_COUNT] = {
+        "avl_rotations_ll",
+        "avl_rotations_rr",
+        "avl_rotations_lr",
+        "avl_rotations_rl",
+        "avl_searches",
+        "avl_search_visits",
+        "segtree_queries",
+        "segtree_query_visits",
+        "trie_inserts",
+        "trie_node_allocations",
+        "persistent_node_allocations",
+        "persistent_node_frees",
+    };
+    return names[c];
+}
+
+
+void Instrumentation::add(Counter c, uint64_t n) {
+    counters[c].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+
+Instrumentation::Snapshot Instrumentation::snapshot() {
+    Snapshot s;
+    for(int c = 0; c < COUNTER_COUNT; ++c) {
+        s.values[c] = counters[c].value.load(std::memory_order_relaxed);
+    }
+
+    s.cacheMisses = 0;
+    s.hasCacheMisses = false;
+#ifdef __linux__
+    if(perfFd != -1) {
+        uint64_t count;
+        if(read(perfFd, &count, sizeof(count)) == sizeof(count)) {
+            s.cacheMisses = count;
+            s.hasCacheMisses = true;
+        }
+    }
+#endif
+    return s;
+}
+
+
+void Instrumentation::reset() {
+    for(Slot& s : counters) {
+        s.value.store(0, std::memory_order_relaxed);
+    }
+#ifdef __linux__
+    if(perfFd != -1) {
+        ioctl(perfFd, PERF_EVENT_IOC_RESET, 0);
+    }
+#endif
+}
+
+
+bool Instrumentation::startCacheMissSampling() {
+#ifdef __linux__
+    if(perfFd != -1)
+        return true;
+
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // This thread (and its future children) on any CPU
+    long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if(fd < 0)
+        return false;
+
+    perfFd = int(fd);
+    ioctl(perfFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(perfFd, PERF_EVENT_IOC_ENABLE, 0);
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void Instrumentation::stopCacheMissSampling() {
+#ifdef __linux__
+    if(perfFd != -1) {
+        close(perfFd);
+        perfFd = -1;
+    }
+#endif
+}
@@ -0,0 +1,125 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+
+/**
+* Counters of the work done inside the hot paths of the structures.
+*
+* Counting is compiled in only when DS_INSTRUMENT is defined
+* (cmake -DDS_INSTRUMENT=ON). Otherwise DS_COUNT expands to nothing and
+* the structures are exactly as fast as without it; snapshots then
+* read all zeros.
+*
+* Counters are process wide and may be bumped from several threads,
+* e.g. by the parallel AVLTree set operations.
+*/
+class Instrumentation {
+public:
+    enum Counter {
+        // AVLTree rebalancing in insertNode() / removeNode(), by case
+        AVL_ROTATIONS_LL,
+        AVL_ROTATIONS_RR,
+        AVL_ROTATIONS_LR,
+        AVL_ROTATIONS_RL,
+
+        // AVLTree::search() calls, and nodes visited by searchNode()
+        AVL_SEARCHES,
+        AVL_SEARCH_VISITS,
+
+        // SegmentTree::query() calls, and nodes visited by queryRecurse()
+        SEGTREE_QUERIES,
+        SEGTREE_QUERY_VISITS,
+
+        // Trie insert() / put() calls, and trie nodes allocated by them
+        TRIE_INSERTS,
+        TRIE_NODE_ALLOCATIONS,
+
+        // PersistentAVLNode allocated and freed, by all versions
+        PERSISTENT_NODE_ALLOCATIONS,
+        PERSISTENT_NODE_FREES,
+
+        COUNTER_COUNT
+    };
+
+    /**
+    * A copy of every counter at one point in time
+    */
+    struct Snapshot {
+        uint64_t values[COUNTER_COUNT];
+
+        /**
+        * Hardware cache misses since `startCacheMissSampling()`,
+        * only meaningful when `hasCacheMisses` is set.
+        */
+        uint64_t cacheMisses;
+        bool hasCacheMisses;
+
+        uint64_t operator[](Counter c) const;
+
+        /**
+        * Writes one "name value" line per counter, the format read by
+        * most metrics exporters (e.g. the Prometheus text format).
+        */
+        friend std::ostream& operator<<(std::ostream& out, const Snapshot& s);
+    };
+
+    /**
+    * Whether the counters are compiled in
+    */
+    static bool enabled();
+
+    /**
+    * Name of the counter, e.g. "avl_rotations_ll"
+    */
+    static const char* name(Counter c);
+
+    static void add(Counter c, uint64_t n = 1);
+
+    static Snapshot snapshot();
+
+    /**
+    * Sets every counter back to 0
+    */
+    static void reset();
+
+    /**
+    * Starts counting hardware cache misses of this thread and of the
+    * threads it creates afterwards, with Linux perf_event_open.
+    * Returns false when they cannot be counted (other platforms, no
+    * permission, no PMU in a VM), snapshots then leave them out.
+    */
+    static bool startCacheMissSampling();
+    static void stopCacheMissSampling();
+
+private:
+    /**
+    * One cache line per counter, so threads bumping different
+    * counters do not slow each other down.
+    */
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value;
+    };
+
+    static Slot counters[COUNTER_COUNT];
+
+    /**
+    * perf_event file descriptor, or -1
+    */
+    static int perfFd;
+};
+
+
+std::ostream& operator<<(std::ostream& out, const Instrumentation::Snapshot& s);
+
+
+#ifdef DS_INSTRUMENT
+#define DS_COUNT(counter, n) Instrumentation::add(Instrumentation::counter, n)
+#else
+#define DS_COUNT(counter, n) ((void)0)
+#endif
+
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,200 @@
+#include "IntervalTree.h"
+
+#include <algorithm>
+#include <utility>
+
+
+IntervalNode::IntervalNode(int lo, int hi)
+    : lo(lo), hi(hi), maxHi(hi), height(0), left(nullptr), right(nullptr) {
+}
+
+
+bool IntervalNode::overlaps(int a, int b) const {
+    return lo <= b && a <= hi;
+}
+
+
+int height(IntervalNode* node) {
+    if(node) {
+        return node->height;
+    } else {
+        return -1;
+    }
+}
+
+
+IntervalTree::IntervalTree() : root(nullptr) {
+}
+
+
+IntervalTree::~IntervalTree() {
+    destroyNode(root);
+}
+
+
+void IntervalTree::update(IntervalNode* node) {
+    node->height = std::max(height(node->left), height(node->right)) + 1;
+    node->maxHi = node->hi;
+    if(node->left)
+        node->maxHi = std::max(node->maxHi, node->left->maxHi);
+    if(node->right)
+        node->maxHi = std::max(node->maxHi, node->right->maxHi);
+}
+
+
+void IntervalTree::insert(int lo, int hi) {
+    insertNode(root, lo, hi);
+}
+
+
+void IntervalTree::insertNode(IntervalNode* & node, int lo, int hi) {
+    if(node == nullptr) {
+        node = new IntervalNode(lo, hi);
+        return;
+    }
+
+    if(std::make_pair(lo, hi) < std::make_pair(node->lo, node->hi)) {
+        insertNode(node->left, lo, hi);
+    } else {
+        insertNode(node->right, lo, hi);
+    }
+    rebalance(node);
+}
+
+
+bool IntervalTree::remove(int lo, int hi) {
+    return removeNode(root, lo, hi);
+}
+
+
+bool IntervalTree::removeNode(IntervalNode* & node, int lo, int hi) {
+    if(node == nullptr)
+        return false;
+
+    bool res = false;
+    std::pair<int, int> key(lo, hi);
+    std::pair<int, int> cur(node->lo, node->hi);
+
+    if(key < cur) {
+        res = removeNode(node->left, lo, hi);
+    } else if (key > cur) {
+        res = removeNode(node->right, lo, hi);
+    } else {
+        // Found node, now delete it
+
+        res = true;
+        if(node->left == nullptr || node->right == nullptr) {
+            // Leaf or one child
+            IntervalNode* temp = node;
+            node = (node->left != nullptr) ? node->left : node->right;
+            delete temp;
+        } else {
+            // Two children, swap in the inorder predecessor
+            IntervalNode* find = node->left;
+            while(find->right != nullptr) {
+                find = find->right;
+            }
+            node->lo = find->lo;
+            node->hi = find->hi;
+
+            // `maxHi` of the whole path down to the predecessor is
+            // recomputed as the recursion unwinds
+            removeNode(node->left, find->lo, find->hi);
+        }
+    }
+
+    if(node != nullptr) {
+        rebalance(node);
+    }
+    return res;
+}
+
+
+void IntervalTree::rebalance(IntervalNode* & node) {
+
+    int hdf = height(node->right) - height(node->left);
+    if (hdf > 1) {
+        // Rebalance right heavy
+
+        IntervalNode* c = node->right;
+        if(height(c->right) >= height(c->left)) {
+            // RR
+            rotateRR(node);
+        } else {
+            // RL
+            rotateLL(node->right);
+            rotateRR(node);
+        }
+    } else if (hdf < -1) {
+        // Rebalance left heavy
+
+        IntervalNode* c = node->left;
+        if(height(c->left) >= height(c->right)) {
+            // LL
+            rotateLL(node);
+        } else {
+            // LR
+            rotateRR(node->left);
+            rotateLL(node);
+        }
+    } else {
+        update(node);
+    }
+}
+
+
+void IntervalTree::rotateLL(IntervalNode* & node) {
+
+    IntervalNode* t2 = node->left->right;
+
+    IntervalNode* temp = node->left;
+    temp->right = node;
+    node->left = t2;
+    node = temp;
+
+    // The demoted node first, the new root depends on it
+    update(node->right);
+    update(node);
+}
+
+
+void IntervalTree::rotateRR(IntervalNode* & node) {
+
+    IntervalNode* t2 = node->right->left;
+
+    IntervalNode* temp = node->right;
+    temp->left = node;
+    node->right = t2;
+    node = temp;
+
+    update(node->left);
+    update(node);
+}
+
+
+IntervalNode* IntervalTree::findAnyOverlap(int lo, int hi) {
+    IntervalNode* node = root;
+    while(node != nullptr) {
+        if(node->overlaps(lo, hi))
+            return node;
+
+        // If the left subtree ends before `lo`, nothing there can overlap.
+        // Otherwise it holds an interval ending at or after `lo`, and if
+        // that one starts after `hi`, so does everything on the right.
+        if(node->left != nullptr && node->left->maxHi >= lo) {
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    return nullptr;
+}
+
+
+void IntervalTree::destroyNode(IntervalNode* node) {
+    if(node != nullptr) {
+        destroyNode(node->left);
+        destroyNode(node->right);
+        delete node;
+    }
+}
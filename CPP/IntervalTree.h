@@ -0,0 +1,158 @@
+#ifndef INTERVALTREE_H
+#define INTERVALTREE_H
+
+class IntervalNode {
+public:
+    /**
+    * The closed interval [lo, hi], nodes are ordered on (lo, hi)
+    */
+    int lo;
+    int hi;
+
+    /**
+    * Largest `hi` in the subtree rooted at this node
+    */
+    int maxHi;
+
+    int height;
+    IntervalNode* left;
+    IntervalNode* right;
+
+    /**
+    * Constructor
+    */
+    IntervalNode(int lo, int hi);
+
+    /**
+    * Returns whether [lo, hi] and [a, b] share at least one point
+    */
+    bool overlaps(int a, int b) const;
+};
+
+
+int height(IntervalNode* node);
+
+
+/**
+* AVL tree of closed intervals, augmented with the largest endpoint of
+* every subtree so that subtrees ending before a query can be skipped.
+*/
+class IntervalTree {
+public:
+    IntervalNode* root;
+
+    /**
+    * Constructor
+    */
+    IntervalTree();
+
+    /**
+    * Destructor, deletes every node.
+    * Trees own their nodes, so they cannot be copied.
+    */
+    ~IntervalTree();
+    IntervalTree(const IntervalTree&) = delete;
+    IntervalTree& operator=(const IntervalTree&) = delete;
+
+    /**
+    * Inserts the interval [lo, hi], lo <= hi
+    */
+    void insert(int lo, int hi);
+
+    /**
+    * Deletes one interval equal to [lo, hi]
+    * Returns a bool to denote success of deletion
+    */
+    bool remove(int lo, int hi);
+
+    /**
+    * Returns a node whose interval overlaps [lo, hi], or `nullptr`.
+    * Runs in O(log n).
+    */
+    IntervalNode* findAnyOverlap(int lo, int hi);
+
+    /**
+    * Calls `fn(node)` in order for every interval overlapping [lo, hi].
+    * Subtrees whose `maxHi` ends before `lo`, or starting after `hi`,
+    * are skipped. Every node visited either overlaps the query or is on
+    * the search path to one which does, so the cost is O(min(n, k log n))
+    * for k results, O(log n) when there is none. Reaching
+    * O(log n + k) would need a centered interval tree or a priority
+    * search tree instead of this augmented AVL tree.
+    */
+    template<typename F>
+    void forEachOverlap(int lo, int hi, F fn);
+
+    /**
+    * Calls `fn(node)` for every interval containing `point`,
+    * with the same cost as `forEachOverlap()`.
+    */
+    template<typename F>
+    void forEachStabbing(int point, F fn);
+
+private:
+    /**
+    * Recursive insertion and deletion called by `insert()` and `remove()`
+    */
+    void insertNode(IntervalNode* & node, int lo, int hi);
+    bool removeNode(IntervalNode* & node, int lo, int hi);
+
+    /**
+    * Recursive query called by `forEachOverlap()`
+    */
+    template<typename F>
+    void overlapNode(IntervalNode* node, int lo, int hi, F& fn);
+
+    /**
+    * Recomputes `height` and `maxHi` of `node` from its children
+    */
+    void update(IntervalNode* node);
+
+    /**
+    * Restores the AVL property at `node`, whose subtrees may differ in
+    * height by at most 2, and updates it.
+    */
+    void rebalance(IntervalNode* & node);
+
+    /**
+    * Same rotations as `AVLTree::rotateLL` and `AVLTree::rotateRR`,
+    * also maintaining `maxHi` of the two nodes which move.
+    */
+    void rotateLL(IntervalNode* & node);
+    void rotateRR(IntervalNode* & node);
+
+    /**
+    * Deletes every node of the subtree rooted at `node`.
+    */
+    void destroyNode(IntervalNode* node);
+};
+
+
+template<typename F>
+void IntervalTree::forEachOverlap(int lo, int hi, F fn) {
+    overlapNode(root, lo, hi, fn);
+}
+
+
+template<typename F>
+void IntervalTree::forEachStabbing(int point, F fn) {
+    overlapNode(root, point, point, fn);
+}
+
+
+template<typename F>
+void IntervalTree::overlapNode(IntervalNode* node, int lo, int hi, F& fn) {
+    if(node == nullptr || node->maxHi < lo)
+        return;
+
+    overlapNode(node->left, lo, hi, fn);
+    if(node->overlaps(lo, hi))
+        fn(node);
+
+    // Intervals on the right start at or after node->lo
+    if(node->lo <= hi)
+        overlapNode(node->right, lo, hi, fn);
+}
+
+
+#endif // INTERVALTREE_H
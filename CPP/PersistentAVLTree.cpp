@@ -0,0 +1,229 @@
+#include "PersistentAVLTree.h"
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <utility>
+
+
+int height(const PersistentAVLNode* node) {
+    if(node) {
+        return node->height;
+    } else {
+        return -1;
+    }
+}
+
+
+PersistentAVLNode::PersistentAVLNode(PersistentAVLNode* l, int v, PersistentAVLNode* r)
+    : val(v), height(std::max(::height(l), ::height(r)) + 1), left(l), right(r), refs(1) {
+    DS_COUNT(PERSISTENT_NODE_ALLOCATIONS, 1);
+}
+
+
+/**
+* Takes one more reference to `node`, returns it
+*/
+PersistentAVLNode* retain(PersistentAVLNode* node) {
+    if(node) {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    return node;
+}
+
+
+/**
+* Drops one reference to `node`, freeing it (and the children it was
+* the last user of) when it was the last one.
+*/
+void release(PersistentAVLNode* node) {
+    if(node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete node;
+    }
+}
+
+
+PersistentAVLNode::~PersistentAVLNode() {
+    release(left);
+    release(right);
+    DS_COUNT(PERSISTENT_NODE_FREES, 1);
+}
+
+
+PersistentAVLTree::PersistentAVLTree() : root(nullptr) {
+}
+
+
+PersistentAVLTree::PersistentAVLTree(const PersistentAVLTree& other)
+    : root(retain(other.root)) {
+}
+
+
+PersistentAVLTree::PersistentAVLTree(PersistentAVLTree&& other) : root(other.root) {
+    other.root = nullptr;
+}
+
+
+PersistentAVLTree& PersistentAVLTree::operator=(PersistentAVLTree other) {
+    std::swap(root, other.root);
+    return *this;
+}
+
+
+PersistentAVLTree::~PersistentAVLTree() {
+    release(root);
+}
+
+
+PersistentAVLTree PersistentAVLTree::snapshot() const {
+    return *this;
+}
+
+
+const PersistentAVLNode* PersistentAVLTree::getRoot() const {
+    return root;
+}
+
+
+void PersistentAVLTree::insert(int val) {
+    PersistentAVLNode* updated = insertNode(root, val);
+    release(root);
+    root = updated;
+}
+
+
+PersistentAVLNode* PersistentAVLTree::insertNode(PersistentAVLNode* node, int val) {
+    if(node == nullptr) {
+        return new PersistentAVLNode(nullptr, val, nullptr);
+    }
+
+    if(val < node->val) {
+        return balance(insertNode(node->left, val), node->val, retain(node->right));
+    } else {
+        return balance(retain(node->left), node->val, insertNode(node->right, val));
+    }
+}
+
+
+bool PersistentAVLTree::remove(int val) {
+    bool res = false;
+    PersistentAVLNode* updated = removeNode(root, val, res);
+    release(root);
+    root = updated;
+    return res;
+}
+
+
+PersistentAVLNode* PersistentAVLTree::removeNode(PersistentAVLNode* node, int val, bool& res) {
+    if(node == nullptr)
+        return nullptr;
+
+    if(val < node->val) {
+        PersistentAVLNode* l = removeNode(node->left, val, res);
+        if(!res) {
+            // Nothing removed, keep sharing this subtree
+            release(l);
+            return retain(node);
+        }
+        return balance(l, node->val, retain(node->right));
+    } else if (val > node->val) {
+        PersistentAVLNode* r = removeNode(node->right, val, res);
+        if(!res) {
+            release(r);
+            return retain(node);
+        }
+        return balance(retain(node->left), node->val, r);
+    }
+
+    // Found node, now delete it
+    res = true;
+    if(node->left == nullptr) {
+        return retain(node->right);
+    } else if (node->right == nullptr) {
+        return retain(node->left);
+    }
+
+    // Two children, replace with the inorder predecessor
+    int pred;
+    PersistentAVLNode* l = removeLast(node->left, pred);
+    return balance(l, pred, retain(node->right));
+}
+
+
+PersistentAVLNode* PersistentAVLTree::removeLast(PersistentAVLNode* node, int& last) {
+    if(node->right == nullptr) {
+        last = node->val;
+        return retain(node->left);
+    }
+    PersistentAVLNode* r = removeLast(node->right, last);
+    return balance(retain(node->left), node->val, r);
+}
+
+
+PersistentAVLNode* PersistentAVLTree::balance(PersistentAVLNode* l, int v, PersistentAVLNode* r) {
+
+    int hdf = height(r) - height(l);
+    if (hdf > 1) {
+        // Rebalance right heavy
+
+        if(height(r->right) >= height(r->left)) {
+            // RR
+            return rotateRR(l, v, r);
+        } else {
+            // RL
+            PersistentAVLNode* cn = rotateLL(retain(r->left), r->val, retain(r->right));
+            release(r);
+            return rotateRR(l, v, cn);
+        }
+    } else if (hdf < -1) {
+        // Rebalance left heavy
+
+        if(height(l->left) >= height(l->right)) {
+            // LL
+            return rotateLL(l, v, r);
+        } else {
+            // LR
+            PersistentAVLNode* cn = rotateRR(retain(l->left), l->val, retain(l->right));
+            release(l);
+            return rotateLL(cn, v, r);
+        }
+    }
+
+    return new PersistentAVLNode(l, v, r);
+}
+
+
+PersistentAVLNode* PersistentAVLTree::rotateLL(PersistentAVLNode* cn, int v, PersistentAVLNode* r) {
+    PersistentAVLNode* res = new PersistentAVLNode(
+        retain(cn->left),
+        cn->val,
+        new PersistentAVLNode(retain(cn->right), v, r)
+    );
+    release(cn);
+    return res;
+}
+
+
+PersistentAVLNode* PersistentAVLTree::rotateRR(PersistentAVLNode* l, int v, PersistentAVLNode* cn) {
+    PersistentAVLNode* res = new PersistentAVLNode(
+        new PersistentAVLNode(l, v, retain(cn->left)),
+        cn->val,
+        retain(cn->right)
+    );
+    release(cn);
+    return res;
+}
+
+
+const PersistentAVLNode* PersistentAVLTree::search(int val) const {
+    const PersistentAVLNode* node = root;
+    while(node != nullptr) {
+        if(val < node->val) {
+            node = node->left;
+        } else if (val > node->val) {
+            node = node->right;
+        } else {
+            return node;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,150 @@
+#ifndef PERSISTENTAVLTREE_H
+#define PERSISTENTAVLTREE_H
+
+#include <atomic>
+
+class PersistentAVLNode {
+public:
+    const int val;
+    const int height;
+    PersistentAVLNode* const left;
+    PersistentAVLNode* const right;
+
+    /**
+    * Number of parents and trees pointing to this node.
+    * Atomic, as snapshots may be released from other threads.
+    */
+    mutable std::atomic<int> refs;
+
+    /**
+    * Constructor, takes over one reference to `l` and `r`
+    * and computes the height from theirs.
+    */
+    PersistentAVLNode(PersistentAVLNode* l, int v, PersistentAVLNode* r);
+
+    ~PersistentAVLNode();
+};
+
+
+int height(const PersistentAVLNode* node);
+
+
+/**
+* AVL tree whose nodes are never modified once built.
+*
+* `insert()` and `remove()` copy only the O(log n) nodes on the path to
+* the value, plus the nodes rewritten by rotations, and share every other
+* subtree with the previous version. A snapshot is a second tree pointing
+* to the same root, so it costs O(1) and stays valid while this tree keeps
+* changing. Nodes are reference counted and freed with the last version
+* using them.
+*
+* A single tree object is not thread safe, but snapshots of it may be
+* read and released on other threads.
+*/
+class PersistentAVLTree {
+public:
+    /**
+    * Constructor
+    */
+    PersistentAVLTree();
+
+    /**
+    * Copies share every node, in O(1)
+    */
+    PersistentAVLTree(const PersistentAVLTree& other);
+    PersistentAVLTree(PersistentAVLTree&& other);
+    PersistentAVLTree& operator=(PersistentAVLTree other);
+
+    ~PersistentAVLTree();
+
+    /**
+    * Returns a point in time view of the tree, in O(1).
+    * Later updates of this tree do not show in the snapshot.
+    */
+    PersistentAVLTree snapshot() const;
+
+    /**
+    * Insert the given value into the tree
+    */
+    void insert(int val);
+
+    /**
+    * Deletes the given value from the tree
+    * Returns a bool to denote success of deletion
+    */
+    bool remove(int val);
+
+    /**
+    * Return a pointer to the first node with value == `val`
+    * If such node doesn't exist, return `nullptr`
+    */
+    const PersistentAVLNode* search(int val) const;
+
+    /**
+    * Calls `fn(value)` in order for every value in [lo, hi]
+    */
+    template<typename F>
+    void forEachInRange(int lo, int hi, F fn) const;
+
+    const PersistentAVLNode* getRoot() const;
+
+private:
+    PersistentAVLNode* root;
+
+    /**
+    * Recursive functions called by `insert()` and `remove()`.
+    * They only borrow `node` and return a new reference to the root of
+    * the updated subtree.
+    */
+    PersistentAVLNode* insertNode(PersistentAVLNode* node, int val);
+    PersistentAVLNode* removeNode(PersistentAVLNode* node, int val, bool& res);
+
+    /**
+    * Detaches the largest value of `node` into `last`,
+    * returns a new reference to the rest of the subtree.
+    */
+    PersistentAVLNode* removeLast(PersistentAVLNode* node, int& last);
+
+    /**
+    * Builds the node (l, v, r), taking over the references to `l` and `r`,
+    * and rebalances it with the same cases as `AVLTree::insertNode`.
+    * A rotation allocates the new nodes in place of `rotateLL` / `rotateRR`
+    * rewriting the old ones.
+    */
+    PersistentAVLNode* balance(PersistentAVLNode* l, int v, PersistentAVLNode* r);
+
+    /**
+    * Builds (l, v, r) after a rotation of `Cr` = (`cn`, v, `r`) (LL)
+    * or (`l`, v, `cn`) (RR). See `AVLTree::rotateLL` for the names.
+    * Takes over the references to all three arguments.
+    */
+    PersistentAVLNode* rotateLL(PersistentAVLNode* cn, int v, PersistentAVLNode* r);
+    PersistentAVLNode* rotateRR(PersistentAVLNode* l, int v, PersistentAVLNode* cn);
+
+    template<typename F>
+    void rangeNode(const PersistentAVLNode* node, int lo, int hi, F& fn) const;
+};
+
+
+template<typename F>
+void PersistentAVLTree::forEachInRange(int lo, int hi, F fn) const {
+    rangeNode(root, lo, hi, fn);
+}
+
+
+template<typename F>
+void PersistentAVLTree::rangeNode(const PersistentAVLNode* node, int lo, int hi, F& fn) const {
+    if(node == nullptr)
+        return;
+
+    if(lo <= node->val)
+        rangeNode(node->left, lo, hi, fn);
+    if(lo <= node->val && node->val <= hi)
+        fn(node->val);
+    if(node->val <= hi)
+        rangeNode(node->right, lo, hi, fn);
+}
+
+
+#endif // PERSISTENTAVLTREE_H
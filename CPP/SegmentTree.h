@@ -0,0 +1,118 @@
+#ifndef SEGMENTTREE_H
+#define SEGMENTTREE_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+class SegmentTree {
+public:
+    /**
+    * Constructor takes the following arguments:
+    *     v   : a vector of integers
+    *     func: a bivariate, associative function,
+    *           for e.g. addition, multiplication.
+    *     def_val: a default value to return when query range
+    *           goes out of bounds
+    */
+    explicit SegmentTree(
+        std::vector<int> v, 
+        std::function<int(const int&, const int&)> func,
+        int def_val
+        );
+
+    /** 
+    * Returns the result of a query on the interval [tl, tr]
+    * based on the `func` passed in the constructor
+    */
+    int query(size_t tl, size_t tr);
+
+    /*
+    * Updates the value of `index`, where `index` is an index in
+    * the vector passed to the constructor
+    * The index is translated into the appropriate binary tree index
+    * while recursing down to the leaf.
+    */
+    void update(size_t index, int val);
+
+    /**
+    * Writes the tree to `path` as a binary image (see BinaryImage.h),
+    * the internal array as it is, so loading it needs no `buildTree()`.
+    */
+    void save(const std::string& path) const;
+
+    /**
+    * Reads back a tree written by `save()`. `func` is not part of the
+    * image and must be the function the saved tree was built with.
+    * Throws `std::runtime_error` if the image is missing or damaged.
+    */
+    static SegmentTree load(
+        const std::string& path,
+        std::function<int(const int&, const int&)> func
+        );
+
+
+private:
+    /**
+    * Empty tree, filled in by `load()`
+    */
+    SegmentTree();
+
+    /*
+    * Internal representation of a binary tree
+    */
+    std::vector<int> arr;
+
+    /**
+    * Value to be used when query parameters go out of bounds
+    */
+    int default_value;
+    
+    /**
+    * A Bivariate, associative function which is the basis of query operations.
+    */
+    std::function<int(int,int)> func;
+
+
+    /**
+    * Count of the number of leaves
+    */
+    size_t vn;
+
+    /**
+    * Recursively construct the tree, where
+    *    v          : input vector
+    *    vi         : index of current node within an array representing a binary tree
+    *                   vi for root = 0
+    *                   vi for left  child of root = 2 * 0 + 1 = 1
+    *                   vi for right child of root = 2 * 0 + 2 = 2
+    *    start, end : The inclusive bounds of the current node.
+    *       For reference, look at the diagram in main()
+    */
+    void buildTree(std::vector<int>& v, size_t vi, size_t start, size_t end);
+
+    /**
+    * Recursively query the tree, where
+    *    vi         : index of current node within an array representing a binary tree
+    *                   vi for root                            = 0
+    *                   vi for left  child of root = 2 * 0 + 1 = 1
+    *                   vi for right child of root = 2 * 0 + 2 = 2
+    *    tl, tr     : inclusive bounds of the query parameters
+    *    start, end : The inclusive bounds of the current node.
+    *       For reference, look at the diagram in main()
+    */
+    int queryRecurse(size_t vi, size_t tl, size_t tr, size_t start, size_t end);
+
+    /**
+    * Recursively update the tree, where
+    *    index      : Index (within the original input vector) to assign the given 
+    *                   `val` at.
+    *    val        : The new value for the index
+    *    start, end : The inclusive bounds of the current node.
+    *       For reference, look at the diagram in main()
+    */
+    void updateRecurse(size_t index, int val, size_t vi, size_t start, size_t end);
+};
+
+#endif // SEGMENTTREE_H
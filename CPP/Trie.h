@@ -0,0 +1,506 @@
+#ifndef TRIE_H
+#define TRIE_H
+
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Alphabets describe how a key is cut into the symbols labelling the
+ * edges of a trie. A key is an array of `Element`, `length(n)` symbols
+ * long for n elements, and `at(key, i)` is its i-th symbol.
+ * Symbols are integers in [0, 2^BITS).
+ */
+
+/**
+ * One symbol per byte, keys are `std::string` or `char` arrays
+ */
+struct ByteAlphabet {
+    typedef char Element;
+    typedef uint8_t Symbol;
+    static const int BITS = 8;
+
+    static size_t length(size_t n) { return n; }
+    static Symbol at(const Element* key, size_t i) { return Symbol(key[i]); }
+};
+
+
+/**
+ * Two symbols per byte, high nibble first.
+ * Twice as deep as `ByteAlphabet`, but every node has at most 16 children.
+ */
+struct NibbleAlphabet {
+    typedef char Element;
+    typedef uint8_t Symbol;
+    static const int BITS = 4;
+
+    static size_t length(size_t n) { return 2 * n; }
+    static Symbol at(const Element* key, size_t i) {
+        return (uint8_t(key[i / 2]) >> ((i % 2) ? 0 : 4)) & 15;
+    }
+};
+
+
+/**
+ * One symbol per token, e.g. uint16_t or uint32_t ids of tokenized text
+ */
+template<typename Token>
+struct TokenAlphabet {
+    typedef Token Element;
+    typedef Token Symbol;
+    static const int BITS = 8 * sizeof(Token);
+
+    static size_t length(size_t n) { return n; }
+    static Symbol at(const Element* key, size_t i) { return key[i]; }
+};
+
+
+/**
+ * A key passed to a trie: `size` elements starting at `data`.
+ * Built implicitly from a std::basic_string, a std::vector,
+ * or, for char keys only, a zero terminated string such as a literal:
+ * 0 is a valid symbol of the other alphabets, e.g. a token id.
+ */
+template<typename Element>
+struct TrieKey {
+    const Element* data;
+    size_t size;
+
+    TrieKey(const Element* data, size_t size) : data(data), size(size) {
+    }
+
+    template<typename E = Element,
+        typename = typename std::enable_if<std::is_same<E, char>::value>::type>
+    TrieKey(const Element* s) : data(s), size(0) {
+        while(s[size] != Element()) {
+            ++size;
+        }
+    }
+
+    TrieKey(const std::vector<Element>& v) : data(v.data()), size(v.size()) {
+    }
+
+    template<typename Traits, typename Alloc>
+    TrieKey(const std::basic_string<Element, Traits, Alloc>& s) : data(s.data()), size(s.size()) {
+    }
+};
+
+
+/**
+ * Value of a trie which only records which keys are present
+ */
+struct NoValue {
+};
+
+
+/**
+ * Trie mapping keys, cut into symbols by `Alphabet`, to a `Value`.
+ *
+ * Nodes come in three kinds:
+ *     LEAF  : no child, the end of one or more keys
+ *     LIST  : children kept in a sorted array of symbols, for the
+ *             usual node with a handful of children
+ *     DIRECT: children in a table indexed by the symbol, for nodes with
+ *             many children. Only used when the alphabet has at most
+ *             2^8 symbols, such a node is then found in one step.
+ * A LIST node becomes DIRECT past 2^BITS / 8 children, and goes back
+ * below 2^BITS / 16.
+ */
+template<typename Alphabet, typename Value>
+class BasicTrie {
+public:
+    typedef typename Alphabet::Element Element;
+    typedef typename Alphabet::Symbol Symbol;
+    typedef TrieKey<Element> Key;
+
+    enum NodeKind {
+        LEAF,
+        LIST,
+        DIRECT,
+        NODE_KINDS
+    };
+
+    /**
+     * Number of nodes, and bytes they use, of each kind.
+     * Bytes include the nodes and their child arrays, but not the
+     * allocator overhead, nor what a `Value` allocates by itself.
+     */
+    struct MemoryUsage {
+        size_t nodes[NODE_KINDS];
+        size_t bytes[NODE_KINDS];
+
+        size_t totalBytes() const {
+            return bytes[LEAF] + bytes[LIST] + bytes[DIRECT];
+        }
+    };
+
+    /**
+     * Default constructor
+     */
+    BasicTrie();
+
+    /**
+     * Destructor, deletes every node.
+     */
+    ~BasicTrie();
+    BasicTrie(const BasicTrie&) = delete;
+    BasicTrie& operator=(const BasicTrie&) = delete;
+
+    /**
+     * Returns a pointer to the value of `key`, or `nullptr` if the key
+     * is not in the Trie. The pointer is valid until `key` is erased.
+     */
+    Value* get(Key key);
+    const Value* get(Key key) const;
+
+    /**
+     * Sets the value of `key`, adding the key if needed.
+     * Returns `true` if the key was added.
+     */
+    bool put(Key key, const Value& value);
+
+    /**
+     * Removes `key` and the nodes only it was using.
+     * Returns `true` if the key was present.
+     */
+    bool erase(Key key);
+
+    /**
+     * Adds `key`, leaving its value alone if it is already present.
+     */
+    void insert(Key key);
+
+    /**
+     * Returns `true` if `key` exists in the Trie,
+     * or, if `key` is present in the Trie as a prefix
+     * of a longer key when `allowPrefix` is `true`.
+     */
+    bool search(Key key, bool allowPrefix = false) const;
+
+    /**
+     * Number of keys
+     */
+    size_t size() const;
+
+    MemoryUsage memoryUsage() const;
+
+private:
+    /**
+     * Number of symbols, for the alphabets which may use DIRECT nodes
+     */
+    static const size_t ALPHABET = size_t(1) << (Alphabet::BITS < 16 ? Alphabet::BITS : 16);
+    static const bool CAN_BE_DIRECT = Alphabet::BITS <= 8;
+    static const size_t DIRECT_MIN = ALPHABET / 8;
+    static const size_t LIST_MAX = ALPHABET / 16;
+
+    struct Node {
+        /**
+         * LIST: labels of `children`, in ascending order.
+         * DIRECT: empty, `children[s]` is the child for symbol s.
+         */
+        std::vector<Symbol> symbols;
+        std::vector<Node*> children;
+        size_t childCount;
+        bool direct;
+        bool hasValue;
+        Value value;
+
+        Node() : childCount(0), direct(false), hasValue(false), value() {
+        }
+
+        NodeKind kind() const {
+            return childCount == 0 ? LEAF : (direct ? DIRECT : LIST);
+        }
+
+        /**
+         * Returns the child for `s`, or `nullptr`
+         */
+        Node* child(Symbol s) const;
+
+        /**
+         * Returns the child for `s`, adding it if it doesn't exist
+         */
+        Node* addChild(Symbol s);
+
+        /**
+         * Deletes the child for `s`, which must be a childless node
+         */
+        void removeChild(Symbol s);
+    };
+
+    Node* root;
+    size_t count;
+
+    /**
+     * Returns the node reached by `key`, or `nullptr`
+     */
+    Node* find(Key key) const;
+};
+
+
+/**
+ * Trie of strings, without values
+ */
+typedef BasicTrie<ByteAlphabet, NoValue> Trie;
+
+template<typename Value>
+using ByteTrie = BasicTrie<ByteAlphabet, Value>;
+
+template<typename Value>
+using NibbleTrie = BasicTrie<NibbleAlphabet, Value>;
+
+template<typename Token, typename Value>
+using TokenTrie = BasicTrie<TokenAlphabet<Token>, Value>;
+
+
+template<typename Alphabet, typename Value>
+typename BasicTrie<Alphabet, Value>::Node* BasicTrie<Alphabet, Value>::Node::child(Symbol s) const {
+    if(direct) {
+        return children[s];
+    }
+    auto it = std::lower_bound(symbols.begin(), symbols.end(), s);
+    if(it == symbols.end() || *it != s) {
+        return nullptr;
+    }
+    return children[it - symbols.begin()];
+}
+
+
+template<typename Alphabet, typename Value>
+typename BasicTrie<Alphabet, Value>::Node* BasicTrie<Alphabet, Value>::Node::addChild(Symbol s) {
+    if(direct) {
+        if(children[s] == nullptr) {
+            children[s] = new Node();
+            DS_COUNT(TRIE_NODE_ALLOCATIONS, 1);
+            ++childCount;
+        }
+        return children[s];
+    }
+
+    auto it = std::lower_bound(symbols.begin(), symbols.end(), s);
+    size_t i = it - symbols.begin();
+    if(it != symbols.end() && *it == s) {
+        return children[i];
+    }
+
+    Node* t = new Node();
+    DS_COUNT(TRIE_NODE_ALLOCATIONS, 1);
+    ++childCount;
+
+    if(CAN_BE_DIRECT && childCount > DIRECT_MIN) {
+        // Switch to a table
+        std::vector<Node*> table(ALPHABET, nullptr);
+        for(size_t k = 0; k < symbols.size(); ++k) {
+            table[symbols[k]] = children[k];
+        }
+        table[s] = t;
+        children.swap(table);
+        std::vector<Symbol>().swap(symbols);
+        direct = true;
+    } else {
+        symbols.insert(it, s);
+        children.insert(children.begin() + i, t);
+    }
+    return t;
+}
+
+
+template<typename Alphabet, typename Value>
+void BasicTrie<Alphabet, Value>::Node::removeChild(Symbol s) {
+    --childCount;
+
+    if(direct) {
+        delete children[s];
+        children[s] = nullptr;
+
+        if(childCount < LIST_MAX) {
+            // Back to a list
+            std::vector<Symbol> syms;
+            std::vector<Node*> list;
+            for(size_t k = 0; k < children.size(); ++k) {
+                if(children[k] != nullptr) {
+                    syms.push_back(Symbol(k));
+                    list.push_back(children[k]);
+                }
+            }
+            symbols.swap(syms);
+            children.swap(list);
+            direct = false;
+        }
+        return;
+    }
+
+    size_t i = std::lower_bound(symbols.begin(), symbols.end(), s) - symbols.begin();
+    delete children[i];
+    symbols.erase(symbols.begin() + i);
+    children.erase(children.begin() + i);
+    if(childCount == 0) {
+        // Leaves hold no arrays
+        std::vector<Symbol>().swap(symbols);
+        std::vector<Node*>().swap(children);
+    }
+}
+
+
+template<typename Alphabet, typename Value>
+BasicTrie<Alphabet, Value>::BasicTrie() : root(new Node()), count(0) {
+}
+
+
+template<typename Alphabet, typename Value>
+BasicTrie<Alphabet, Value>::~BasicTrie() {
+    // Iterative, keys may be much longer than the call stack allows
+    std::vector<Node*> stack(1, root);
+    while(!stack.empty()) {
+        Node* t = stack.back();
+        stack.pop_back();
+        for(Node* c : t->children) {
+            if(c != nullptr)
+                stack.push_back(c);
+        }
+        delete t;
+    }
+}
+
+
+template<typename Alphabet, typename Value>
+typename BasicTrie<Alphabet, Value>::Node* BasicTrie<Alphabet, Value>::find(Key key) const {
+    Node* t = root;
+    size_t n = Alphabet::length(key.size);
+    for(size_t i = 0; i < n && t != nullptr; ++i) {
+        t = t->child(Alphabet::at(key.data, i));
+    }
+    return t;
+}
+
+
+template<typename Alphabet, typename Value>
+Value* BasicTrie<Alphabet, Value>::get(Key key) {
+    Node* t = find(key);
+    return (t != nullptr && t->hasValue) ? &t->value : nullptr;
+}
+
+
+template<typename Alphabet, typename Value>
+const Value* BasicTrie<Alphabet, Value>::get(Key key) const {
+    Node* t = find(key);
+    return (t != nullptr && t->hasValue) ? &t->value : nullptr;
+}
+
+
+template<typename Alphabet, typename Value>
+bool BasicTrie<Alphabet, Value>::put(Key key, const Value& value) {
+    DS_COUNT(TRIE_INSERTS, 1);
+
+    Node* t = root;
+    size_t n = Alphabet::length(key.size);
+    for(size_t i = 0; i < n; ++i) {
+        t = t->addChild(Alphabet::at(key.data, i));
+    }
+
+    bool added = !t->hasValue;
+    t->hasValue = true;
+    t->value = value;
+    count += added;
+    return added;
+}
+
+
+template<typename Alphabet, typename Value>
+bool BasicTrie<Alphabet, Value>::erase(Key key) {
+    // Nodes from the root down to the end of `key`
+    size_t n = Alphabet::length(key.size);
+    std::vector<Node*> path;
+    path.reserve(n + 1);
+
+    Node* t = root;
+    path.push_back(t);
+    for(size_t i = 0; i < n; ++i) {
+        t = t->child(Alphabet::at(key.data, i));
+        if(t == nullptr) {
+            return false;
+        }
+        path.push_back(t);
+    }
+
+    if(!t->hasValue) {
+        return false;
+    }
+    t->hasValue = false;
+    t->value = Value();
+    --count;
+
+    // Delete the nodes left with neither a value nor a child
+    for(size_t i = n; i > 0; --i) {
+        Node* c = path[i];
+        if(c->hasValue || c->childCount != 0)
+            break;
+        path[i - 1]->removeChild(Alphabet::at(key.data, i - 1));
+    }
+    return true;
+}
+
+
+template<typename Alphabet, typename Value>
+void BasicTrie<Alphabet, Value>::insert(Key key) {
+    DS_COUNT(TRIE_INSERTS, 1);
+
+    Node* t = root;
+    size_t n = Alphabet::length(key.size);
+    for(size_t i = 0; i < n; ++i) {
+        t = t->addChild(Alphabet::at(key.data, i));
+    }
+
+    count += !t->hasValue;
+    t->hasValue = true;
+}
+
+
+template<typename Alphabet, typename Value>
+bool BasicTrie<Alphabet, Value>::search(Key key, bool allowPrefix) const {
+    Node* t = find(key);
+    return t != nullptr && (allowPrefix || t->hasValue);
+}
+
+
+template<typename Alphabet, typename Value>
+size_t BasicTrie<Alphabet, Value>::size() const {
+    return count;
+}
+
+
+template<typename Alphabet, typename Value>
+typename BasicTrie<Alphabet, Value>::MemoryUsage BasicTrie<Alphabet, Value>::memoryUsage() const {
+    MemoryUsage usage;
+    for(int k = 0; k < NODE_KINDS; ++k) {
+        usage.nodes[k] = 0;
+        usage.bytes[k] = 0;
+    }
+
+    std::vector<const Node*> stack(1, root);
+    while(!stack.empty()) {
+        const Node* t = stack.back();
+        stack.pop_back();
+
+        NodeKind k = t->kind();
+        usage.nodes[k] += 1;
+        usage.bytes[k] += sizeof(Node)
+            + t->symbols.capacity() * sizeof(Symbol)
+            + t->children.capacity() * sizeof(Node*);
+
+        for(const Node* c : t->children) {
+            if(c != nullptr)
+                stack.push_back(c);
+        }
+    }
+    return usage;
+}
+
+
+#endif // TRIE_H
@@ -0,0 +1,403 @@
+#ifndef VANEMDEBOAS_H
+#define VANEMDEBOAS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+* Index of the lowest (resp. highest) set bit, `x` must not be 0
+*/
+inline int lowestBit(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return i;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+
+inline int highestBit(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanReverse64(&i, x);
+    return i;
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+
+/**
+* Universes of at most 2^LEAF_BITS values are a single 64 bit word
+*/
+const int LEAF_BITS = 6;
+
+
+/**
+* Node of a van Emde Boas tree over the universe [0, 2^BITS).
+*
+* `min` is kept out of the clusters, `max` is also kept in them.
+* A value x lives in cluster high(x) at position low(x), where high(x)
+* is made of the top BITS - BITS/2 bits of x and low(x) of the others.
+* Clusters, and the summary of which clusters are non empty, are only
+* allocated once they hold a value.
+* The clusters are in a direct table when there are at most 2^DIRECT_HI
+* of them (see ClusterTable).
+*/
+template<int BITS, int DIRECT_HI = 8, bool LEAF = (BITS <= LEAF_BITS)>
+class VEBNode;
+
+
+/**
+* Leaf: the set is a bitmap, every operation is a few bit instructions
+*/
+template<int BITS, int DIRECT_HI>
+class VEBNode<BITS, DIRECT_HI, true> {
+public:
+    VEBNode() : bits(0) {
+    }
+
+    bool empty() const { return bits == 0; }
+    uint64_t min() const { return lowestBit(bits); }
+    uint64_t max() const { return highestBit(bits); }
+
+    bool contains(uint64_t x) const {
+        return (bits >> x) & 1;
+    }
+
+    bool insert(uint64_t x) {
+        uint64_t b = uint64_t(1) << x;
+        bool added = !(bits & b);
+        bits |= b;
+        return added;
+    }
+
+    bool erase(uint64_t x) {
+        uint64_t b = uint64_t(1) << x;
+        bool removed = bits & b;
+        bits &= ~b;
+        return removed;
+    }
+
+    bool successor(uint64_t x, uint64_t& out) const {
+        if(x >= 63)
+            return false;
+        uint64_t above = bits & (~uint64_t(0) << (x + 1));
+        if(above == 0)
+            return false;
+        out = lowestBit(above);
+        return true;
+    }
+
+    bool predecessor(uint64_t x, uint64_t& out) const {
+        uint64_t below = bits & ((uint64_t(1) << x) - 1);
+        if(below == 0)
+            return false;
+        out = highestBit(below);
+        return true;
+    }
+
+private:
+    uint64_t bits;
+};
+
+
+/**
+* Clusters of a node, indexed by high(x).
+* Directly indexed when DIRECT is set, the table being allocated with
+* the first cluster, hashed otherwise.
+*/
+template<int HI, typename Cluster, bool DIRECT>
+class ClusterTable;
+
+
+template<int HI, typename Cluster>
+class ClusterTable<HI, Cluster, true> {
+public:
+    Cluster* find(uint64_t h) const {
+        return table.empty() ? nullptr : table[h].get();
+    }
+
+    Cluster& create(uint64_t h) {
+        if(table.empty()) {
+            table.resize(size_t(1) << HI);
+        }
+        table[h].reset(new Cluster());
+        return *table[h];
+    }
+
+    void erase(uint64_t h) {
+        table[h].reset();
+    }
+
+private:
+    std::vector<std::unique_ptr<Cluster>> table;
+};
+
+
+template<int HI, typename Cluster>
+class ClusterTable<HI, Cluster, false> {
+public:
+    Cluster* find(uint64_t h) const {
+        auto it = table.find(h);
+        return it == table.end() ? nullptr : it->second.get();
+    }
+
+    Cluster& create(uint64_t h) {
+        std::unique_ptr<Cluster>& c = table[h];
+        c.reset(new Cluster());
+        return *c;
+    }
+
+    void erase(uint64_t h) {
+        table.erase(h);
+    }
+
+private:
+    std::unordered_map<uint64_t, std::unique_ptr<Cluster>> table;
+};
+
+
+template<int BITS, int DIRECT_HI>
+class VEBNode<BITS, DIRECT_HI, false> {
+public:
+    static const int LO = BITS / 2;
+    static const int HI = BITS - LO;
+
+    typedef VEBNode<LO> Cluster;
+    typedef VEBNode<HI> Summary;
+
+    VEBNode() : isEmpty(true), lo(0), hi(0) {
+    }
+
+    bool empty() const { return isEmpty; }
+    uint64_t min() const { return lo; }
+    uint64_t max() const { return hi; }
+
+    bool contains(uint64_t x) const {
+        if(isEmpty)
+            return false;
+        if(x == lo || x == hi)
+            return true;
+        Cluster* c = clusters.find(high(x));
+        return c != nullptr && c->contains(low(x));
+    }
+
+    bool insert(uint64_t x) {
+        if(isEmpty) {
+            isEmpty = false;
+            lo = hi = x;
+            return true;
+        }
+        if(x == lo || x == hi)
+            return false;
+
+        if(x < lo) {
+            // `x` becomes the min, the old min goes into the clusters
+            std::swap(x, lo);
+        }
+        if(x > hi) {
+            hi = x;
+        }
+
+        uint64_t h = high(x);
+        Cluster* c = clusters.find(h);
+        if(c == nullptr) {
+            // New cluster, the only recursive call is on the summary
+            if(!summary) {
+                summary.reset(new Summary());
+            }
+            summary->insert(h);
+            clusters.create(h).insert(low(x));
+            return true;
+        }
+        return c->insert(low(x));
+    }
+
+    bool erase(uint64_t x) {
+        if(isEmpty)
+            return false;
+
+        if(lo == hi) {
+            if(x != lo)
+                return false;
+            isEmpty = true;
+            return true;
+        }
+
+        if(x == lo) {
+            // The smallest value of the clusters becomes the min
+            uint64_t h = summary->min();
+            x = index(h, clusters.find(h)->min());
+            lo = x;
+        }
+
+        uint64_t h = high(x);
+        Cluster* c = clusters.find(h);
+        if(c == nullptr || !c->erase(low(x)))
+            return false;
+
+        if(c->empty()) {
+            clusters.erase(h);
+            summary->erase(h);
+            if(summary->empty()) {
+                summary.reset();
+            }
+        }
+
+        if(x == hi) {
+            if(!summary) {
+                hi = lo;
+            } else {
+                uint64_t mh = summary->max();
+                hi = index(mh, clusters.find(mh)->max());
+            }
+        }
+        return true;
+    }
+
+    bool successor(uint64_t x, uint64_t& out) const {
+        if(isEmpty || x >= hi)
+            return false;
+        if(x < lo) {
+            out = lo;
+            return true;
+        }
+
+        uint64_t h = high(x);
+        uint64_t l = low(x);
+        Cluster* c = clusters.find(h);
+        if(c != nullptr && l < c->max()) {
+            // Answer is in the same cluster
+            c->successor(l, out);
+            out = index(h, out);
+            return true;
+        }
+
+        // Answer is the min of the next non empty cluster,
+        // which exists since x < hi and hi is stored in a cluster
+        uint64_t next = 0;
+        summary->successor(h, next);
+        out = index(next, clusters.find(next)->min());
+        return true;
+    }
+
+    bool predecessor(uint64_t x, uint64_t& out) const {
+        if(isEmpty || x <= lo)
+            return false;
+        if(x > hi) {
+            out = hi;
+            return true;
+        }
+
+        uint64_t h = high(x);
+        uint64_t l = low(x);
+        Cluster* c = clusters.find(h);
+        if(c != nullptr && l > c->min()) {
+            c->predecessor(l, out);
+            out = index(h, out);
+            return true;
+        }
+
+        uint64_t prev = 0;
+        if(summary && summary->predecessor(h, prev)) {
+            out = index(prev, clusters.find(prev)->max());
+        } else {
+            // Only the min, which is not in any cluster, is smaller
+            out = lo;
+        }
+        return true;
+    }
+
+private:
+    bool isEmpty;
+    uint64_t lo;
+    uint64_t hi;
+
+    std::unique_ptr<Summary> summary;
+    ClusterTable<HI, Cluster, (HI <= DIRECT_HI)> clusters;
+
+    static uint64_t high(uint64_t x) { return x >> LO; }
+    static uint64_t low(uint64_t x) { return x & ((uint64_t(1) << LO) - 1); }
+    static uint64_t index(uint64_t h, uint64_t l) { return (h << LO) | l; }
+};
+
+
+/**
+* Set of integers in [0, 2^BITS) with O(log log U) insert, erase,
+* successor and predecessor, for BITS up to 64.
+*/
+template<int BITS>
+class VanEmdeBoas {
+public:
+    static_assert(BITS >= 1 && BITS <= 64, "universe must fit in 64 bits");
+
+    VanEmdeBoas() : count(0) {
+    }
+
+    /**
+    * Inserts `x`, returns `false` if it was already present
+    */
+    bool insert(uint64_t x) {
+        bool added = root.insert(x);
+        count += added;
+        return added;
+    }
+
+    /**
+    * Deletes `x`, returns a bool to denote success of deletion
+    */
+    bool erase(uint64_t x) {
+        bool removed = root.erase(x);
+        count -= removed;
+        return removed;
+    }
+
+    bool contains(uint64_t x) const {
+        return root.contains(x);
+    }
+
+    /**
+    * Stores in `out` the smallest value > x (resp. largest value < x)
+    * and returns `true`, or returns `false` if there is none.
+    */
+    bool successor(uint64_t x, uint64_t& out) const {
+        return root.successor(x, out);
+    }
+
+    bool predecessor(uint64_t x, uint64_t& out) const {
+        return root.predecessor(x, out);
+    }
+
+    /**
+    * Smallest and largest values, the set must not be empty
+    */
+    uint64_t min() const { return root.min(); }
+    uint64_t max() const { return root.max(); }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+private:
+    /**
+    * Inner nodes only index directly up to 2^8 clusters (a 2 KB table):
+    * every node holding two values allocates its table, a 2^16 one would
+    * cost 512 KB for each VEBNode<32> of a VanEmdeBoas<64>.
+    * There is a single root, which may use up to 2^16 entries.
+    */
+    VEBNode<BITS, 16> root;
+    size_t count;
+};
+
+
+#endif // VANEMDEBOAS_H
@@ -0,0 +1,593 @@
+/**
+* Microbenchmarks for the C++ data structures.
+*
+* Every (structure, operation, key distribution, size) case is run twice:
+* once untimed per operation, for throughput, then again on a fresh
+* structure with about `--samples` operations timed one by one, spread
+* over the whole run, for latency percentiles. A single operation timing
+* includes the overhead of std::chrono::steady_clock (~20ns).
+*
+* The `avlset` cases time AVLTree set operations on two trees of n keys,
+* once per `--threads` count, the op being named e.g. "union/4". Each one
+* is a single bulk operation, run BULK_RUNS times on fresh trees: ns/op is
+* per key for the best run, and the percentiles are those of whole runs.
+* Comparing "union/1" with "union/8" gives the parallel speedup.
+*
+* Usage:
+*   benchmark [--sizes=1e3,1e4,...] [--dists=uniform,zipf,sorted,ladder]
+*             [--structures=avl,compact,set,veb,segtree,trie,avlset]
+*             [--threads=1,8] [--format=table|csv|json] [--samples=N] [--seed=N]
+*
+* Key distributions:
+*   uniform : random keys in [0, 2^31)
+*   zipf    : keys drawn with Zipf skew (theta = 0.99) from n distinct keys
+*   sorted  : 0, 1, ..., n-1, the "right ladder" of AVLTree
+*   ladder  : 0, n-1, 1, n-2, ..., closing in from both ends. Nearly
+*             every AVLTree insert rotates, with a double rotation for
+*             about 5 inserts in 8 and a single one for 3 in 8
+*
+* `--format=json` writes one JSON object per line, `--format=csv` a header
+* and one row per case, both meant to be appended to a history file.
+*/
+
+#include "AVLTree.h"
+#include "CompactAVLTree.h"
+#include "SegmentTree.h"
+#include "Trie.h"
+#include "VanEmdeBoas.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+* Results are added here so that the compiler keeps every operation
+*/
+volatile uint64_t sink = 0;
+
+
+struct Options {
+    std::vector<size_t> sizes;
+    std::vector<std::string> dists;
+    std::vector<std::string> structures;
+
+    /**
+    * Thread counts for the `avlset` cases
+    */
+    std::vector<unsigned> threads;
+    std::string format;
+    size_t samples;
+    uint64_t seed;
+};
+
+
+struct Result {
+    std::string structure;
+    std::string op;
+    std::string dist;
+    size_t n;
+    double nsPerOp;
+    double opsPerSec;
+
+    /**
+    * Latency percentiles in nanoseconds: p50, p90, p99, p99.9, max
+    */
+    double p[5];
+};
+
+
+/**
+* Zipf distributed ranks in [0, n), as generated by YCSB
+* (Gray et al., Quickly Generating Billion-Record Synthetic Databases)
+*/
+class Zipf {
+public:
+    Zipf(uint64_t n, double theta) : n(n), theta(theta) {
+        double zeta2 = zeta(2);
+        zetan = zeta(n);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan);
+    }
+
+    uint64_t next(std::mt19937_64& rng) {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        double uz = u * zetan;
+        if(uz < 1)
+            return 0;
+        if(uz < 1 + std::pow(0.5, theta))
+            return 1;
+        uint64_t r = n * std::pow(eta * u - eta + 1, alpha);
+        return std::min(r, n - 1);
+    }
+
+private:
+    uint64_t n;
+    double theta;
+    double zetan;
+    double alpha;
+    double eta;
+
+    double zeta(uint64_t m) {
+        double sum = 0;
+        for(uint64_t i = 1; i <= m; ++i) {
+            sum += 1 / std::pow(double(i), theta);
+        }
+        return sum;
+    }
+};
+
+
+/**
+* Spreads the Zipf ranks over [0, 2^31), so hot keys are not neighbours
+*/
+int scramble(uint64_t x) {
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return int(x & 0x7fffffff);
+}
+
+
+/**
+* Returns `n` keys following the distribution `dist`
+*/
+std::vector<int> makeKeys(const std::string& dist, size_t n, uint64_t seed) {
+    std::vector<int> keys(n);
+    std::mt19937_64 rng(seed);
+
+    if(dist == "uniform") {
+        for(size_t i = 0; i < n; ++i) {
+            keys[i] = int(rng() & 0x7fffffff);
+        }
+    } else if (dist == "zipf") {
+        Zipf zipf(n, 0.99);
+        for(size_t i = 0; i < n; ++i) {
+            keys[i] = scramble(zipf.next(rng));
+        }
+    } else if (dist == "sorted") {
+        for(size_t i = 0; i < n; ++i) {
+            keys[i] = int(i);
+        }
+    } else if (dist == "ladder") {
+        for(size_t i = 0; i < n; ++i) {
+            keys[i] = int((i % 2 == 0) ? i / 2 : n - 1 - i / 2);
+        }
+    } else {
+        std::cerr << "unknown distribution: " << dist << std::endl;
+        std::exit(1);
+    }
+    return keys;
+}
+
+
+/**
+* Keys to look up once `keys` have been inserted.
+* Uniform probes are the inserted keys in random order, Zipf probes are
+* a second draw over the same keys, sorted and ladder replay the inserts.
+*/
+std::vector<int> makeProbes(const std::string& dist, const std::vector<int>& keys, uint64_t seed) {
+    if(dist == "uniform") {
+        std::vector<int> probes(keys);
+        std::shuffle(probes.begin(), probes.end(), std::mt19937_64(seed));
+        return probes;
+    } else if (dist == "zipf") {
+        return makeKeys(dist, keys.size(), seed);
+    }
+    return keys;
+}
+
+
+/**
+* Value at fraction `q` of the sorted latencies
+*/
+double percentile(const std::vector<uint64_t>& sorted, double q) {
+    size_t i = std::min(sorted.size() - 1, size_t(q * sorted.size()));
+    return double(sorted[i]);
+}
+
+
+/**
+* Runs the operations op(0), ..., op(n-1) twice, calling `reset()`
+* before each run to start again from the same state.
+*/
+Result measure(
+    const std::string& structure,
+    const std::string& op,
+    const std::string& dist,
+    size_t n,
+    const Options& opt,
+    std::function<void()> reset,
+    std::function<void(size_t)> fn
+    ) {
+
+    Result r;
+    r.structure = structure;
+    r.op = op;
+    r.dist = dist;
+    r.n = n;
+
+    // Throughput
+    reset();
+    Clock::time_point start = Clock::now();
+    for(size_t i = 0; i < n; ++i) {
+        fn(i);
+    }
+    std::chrono::duration<double, std::nano> total = Clock::now() - start;
+    r.nsPerOp = total.count() / n;
+    r.opsPerSec = 1e9 / r.nsPerOp;
+
+    // Latency, one operation out of `stride`
+    reset();
+    size_t stride = std::max<size_t>(1, n / std::max<size_t>(1, opt.samples));
+    std::vector<uint64_t> latencies;
+    latencies.reserve(n / stride + 1);
+    for(size_t i = 0; i < n; ++i) {
+        if(i % stride == 0) {
+            Clock::time_point t = Clock::now();
+            fn(i);
+            latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - t).count());
+        } else {
+            fn(i);
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    r.p[0] = percentile(latencies, 0.50);
+    r.p[1] = percentile(latencies, 0.90);
+    r.p[2] = percentile(latencies, 0.99);
+    r.p[3] = percentile(latencies, 0.999);
+    r.p[4] = double(latencies.back());
+    return r;
+}
+
+
+/**
+* Number of runs of a bulk operation
+*/
+const int BULK_RUNS = 5;
+
+
+/**
+* Times `fn`, one operation over `n` keys as a whole, BULK_RUNS times,
+* calling `reset()` untimed before each run.
+*/
+Result measureBulk(
+    const std::string& structure,
+    const std::string& op,
+    const std::string& dist,
+    size_t n,
+    std::function<void()> reset,
+    std::function<void()> fn
+    ) {
+
+    Result r;
+    r.structure = structure;
+    r.op = op;
+    r.dist = dist;
+    r.n = n;
+
+    std::vector<uint64_t> runs;
+    for(int k = 0; k < BULK_RUNS; ++k) {
+        reset();
+        Clock::time_point start = Clock::now();
+        fn();
+        runs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start).count());
+    }
+
+    std::sort(runs.begin(), runs.end());
+    r.nsPerOp = double(runs.front()) / n;
+    r.opsPerSec = 1e9 / r.nsPerOp;
+    r.p[0] = percentile(runs, 0.50);
+    r.p[1] = percentile(runs, 0.90);
+    r.p[2] = percentile(runs, 0.99);
+    r.p[3] = percentile(runs, 0.999);
+    r.p[4] = double(runs.back());
+    return r;
+}
+
+
+/**
+* Sorted distinct values of `keys`, as `AVLTree::buildFromSorted()` needs
+*/
+std::vector<int> sortedSet(std::vector<int> keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+
+/**
+* Writes one result in the chosen format
+*/
+void report(const Result& r, const Options& opt, bool first) {
+    static const char* names[5] = {"p50", "p90", "p99", "p999", "max"};
+
+    if(opt.format == "json") {
+        std::cout << "{\"schema\":1"
+                  << ",\"timestamp\":" << std::time(nullptr)
+                  << ",\"structure\":\"" << r.structure << "\""
+                  << ",\"op\":\"" << r.op << "\""
+                  << ",\"dist\":\"" << r.dist << "\""
+                  << ",\"n\":" << r.n
+                  << ",\"ns_per_op\":" << r.nsPerOp
+                  << ",\"ops_per_sec\":" << r.opsPerSec;
+        for(int k = 0; k < 5; ++k) {
+            std::cout << ",\"" << names[k] << "_ns\":" << r.p[k];
+        }
+        std::cout << "}" << std::endl;
+    } else if (opt.format == "csv") {
+        if(first) {
+            std::cout << "timestamp,structure,op,dist,n,ns_per_op,ops_per_sec";
+            for(int k = 0; k < 5; ++k) {
+                std::cout << "," << names[k] << "_ns";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << std::time(nullptr) << "," << r.structure << "," << r.op << ","
+                  << r.dist << "," << r.n << "," << r.nsPerOp << "," << r.opsPerSec;
+        for(int k = 0; k < 5; ++k) {
+            std::cout << "," << r.p[k];
+        }
+        std::cout << std::endl;
+    } else {
+        if(first) {
+            std::cout << std::left << std::setw(10) << "structure" << std::setw(11) << "op"
+                      << std::setw(9) << "dist" << std::right << std::setw(11) << "n"
+                      << std::setw(10) << "ns/op" << std::setw(13) << "ops/s";
+            for(int k = 0; k < 5; ++k) {
+                std::cout << std::setw(12) << names[k];
+            }
+            std::cout << std::endl;
+        }
+        std::cout << std::left << std::setw(10) << r.structure << std::setw(11) << r.op
+                  << std::setw(9) << r.dist << std::right << std::setw(11) << r.n
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << r.nsPerOp << std::setw(13) << std::setprecision(0) << r.opsPerSec;
+        for(int k = 0; k < 5; ++k) {
+            std::cout << std::setw(12) << r.p[k];
+        }
+        std::cout << std::endl;
+    }
+}
+
+
+/**
+* Runs every benchmark of one structure for one size and distribution
+*/
+std::vector<Result> runStructure(
+    const std::string& structure,
+    const std::string& dist,
+    size_t n,
+    const std::vector<int>& keys,
+    const std::vector<int>& probes,
+    const Options& opt
+    ) {
+
+    std::vector<Result> results;
+
+    if(structure == "avl") {
+        std::unique_ptr<AVLTree> tree;
+        results.push_back(measure(structure, "insert", dist, n, opt,
+            [&]() { tree.reset(new AVLTree()); },
+            [&](size_t i) { tree->insert(keys[i]); }));
+        results.push_back(measure(structure, "search", dist, n, opt,
+            []() {},
+            [&](size_t i) { sink += (tree->search(probes[i]) != nullptr); }));
+        results.push_back(measure(structure, "successor", dist, n, opt,
+            []() {},
+            [&](size_t i) {
+                AVLTree::iterator it = tree->upper_bound(probes[i]);
+                sink += (it != tree->end()) ? *it : 0;
+            }));
+    } else if (structure == "compact") {
+        std::unique_ptr<CompactAVLTree> tree;
+        results.push_back(measure(structure, "insert", dist, n, opt,
+            [&]() { tree.reset(new CompactAVLTree()); },
+            [&](size_t i) { tree->insert(keys[i]); }));
+        results.push_back(measure(structure, "search", dist, n, opt,
+            []() {},
+            [&](size_t i) { sink += tree->search(probes[i]); }));
+    } else if (structure == "set") {
+        std::unique_ptr<std::set<int>> tree;
+        results.push_back(measure(structure, "insert", dist, n, opt,
+            [&]() { tree.reset(new std::set<int>()); },
+            [&](size_t i) { tree->insert(keys[i]); }));
+        results.push_back(measure(structure, "search", dist, n, opt,
+            []() {},
+            [&](size_t i) { sink += tree->count(probes[i]); }));
+        results.push_back(measure(structure, "successor", dist, n, opt,
+            []() {},
+            [&](size_t i) {
+                auto it = tree->upper_bound(probes[i]);
+                sink += (it != tree->end()) ? *it : 0;
+            }));
+    } else if (structure == "veb") {
+        std::unique_ptr<VanEmdeBoas<32>> tree;
+        results.push_back(measure(structure, "insert", dist, n, opt,
+            [&]() { tree.reset(new VanEmdeBoas<32>()); },
+            [&](size_t i) { tree->insert(uint32_t(keys[i])); }));
+        results.push_back(measure(structure, "search", dist, n, opt,
+            []() {},
+            [&](size_t i) { sink += tree->contains(uint32_t(probes[i])); }));
+        results.push_back(measure(structure, "successor", dist, n, opt,
+            []() {},
+            [&](size_t i) {
+                uint64_t out = 0;
+                tree->successor(uint32_t(probes[i]), out);
+                sink += out;
+            }));
+    } else if (structure == "segtree") {
+        // Keys modulo n are the positions queried or updated
+        std::vector<int> values(keys);
+        auto add = [](int a, int b) { return a + b; };
+        std::unique_ptr<SegmentTree> tree(new SegmentTree(values, add, 0));
+
+        results.push_back(measure(structure, "query", dist, n, opt,
+            []() {},
+            [&](size_t i) {
+                size_t l = size_t(probes[i]) % n;
+                size_t r = std::min(n - 1, l + i % 1024);
+                sink += tree->query(l, r);
+            }));
+        results.push_back(measure(structure, "update", dist, n, opt,
+            []() {},
+            [&](size_t i) { tree->update(size_t(keys[i]) % n, int(i)); }));
+    } else if (structure == "trie") {
+        std::vector<std::string> words(n), lookups(n);
+        for(size_t i = 0; i < n; ++i) {
+            words[i] = std::to_string(keys[i]);
+            lookups[i] = std::to_string(probes[i]);
+        }
+
+        std::unique_ptr<Trie> trie;
+        results.push_back(measure(structure, "insert", dist, n, opt,
+            [&]() { trie.reset(new Trie()); },
+            [&](size_t i) { trie->insert(words[i]); }));
+        results.push_back(measure(structure, "search", dist, n, opt,
+            []() {},
+            [&](size_t i) { sink += trie->search(lookups[i]); }));
+    } else if (structure == "avlset") {
+        // `keys` against a second draw of the same distribution, which
+        // the sorted and ladder distributions make identical
+        std::vector<int> as = sortedSet(keys);
+        std::vector<int> bs = sortedSet(makeKeys(dist, n, opt.seed + 2));
+        std::unique_ptr<AVLTree> a, b;
+        auto reset = [&]() {
+            a.reset(new AVLTree());
+            b.reset(new AVLTree());
+            a->buildFromSorted(as);
+            b->buildFromSorted(bs);
+        };
+
+        for(unsigned t : opt.threads) {
+            std::string suffix = "/" + std::to_string(t);
+            results.push_back(measureBulk(structure, "union" + suffix, dist, n,
+                reset, [&]() { a->unionWith(*b, t); }));
+            results.push_back(measureBulk(structure, "inter" + suffix, dist, n,
+                reset, [&]() { a->intersectWith(*b, t); }));
+            results.push_back(measureBulk(structure, "diff" + suffix, dist, n,
+                reset, [&]() { a->differenceWith(*b, t); }));
+        }
+    } else {
+        std::cerr << "unknown structure: " << structure << std::endl;
+        std::exit(1);
+    }
+    return results;
+}
+
+
+/**
+* Splits "a,b,c" into its parts
+*/
+std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string part;
+    while(std::getline(ss, part, ',')) {
+        if(!part.empty())
+            parts.push_back(part);
+    }
+    return parts;
+}
+
+
+Options parseOptions(int argc, char** argv) {
+    Options opt;
+    opt.sizes = {1000, 10000, 100000, 1000000};
+    opt.dists = {"uniform", "zipf", "sorted", "ladder"};
+    opt.structures = {"avl", "compact", "set", "veb", "segtree", "trie", "avlset"};
+    opt.threads = {1};
+    if(std::thread::hardware_concurrency() > 1) {
+        opt.threads.push_back(std::thread::hardware_concurrency());
+    }
+    opt.format = "table";
+    opt.samples = 100000;
+    opt.seed = 42;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+        if(name == "--sizes") {
+            opt.sizes.clear();
+            for(const std::string& s : splitList(value)) {
+                // Accepts 1e6 as well as 1000000
+                double d = std::stod(s);
+                if(d < 1 || d > 1e8) {
+                    std::cerr << "sizes must be in [1, 1e8]" << std::endl;
+                    std::exit(1);
+                }
+                opt.sizes.push_back(size_t(d));
+            }
+        } else if (name == "--dists") {
+            opt.dists = splitList(value);
+        } else if (name == "--structures") {
+            opt.structures = splitList(value);
+        } else if (name == "--threads") {
+            opt.threads.clear();
+            for(const std::string& s : splitList(value)) {
+                int t = std::stoi(s);
+                if(t < 1) {
+                    std::cerr << "threads must be at least 1" << std::endl;
+                    std::exit(1);
+                }
+                opt.threads.push_back(unsigned(t));
+            }
+        } else if (name == "--format") {
+            opt.format = value;
+        } else if (name == "--samples") {
+            opt.samples = std::stoull(value);
+        } else if (name == "--seed") {
+            opt.seed = std::stoull(value);
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--sizes=1e3,1e4] [--dists=uniform,zipf,sorted,ladder]"
+                      << " [--structures=avl,compact,set,veb,segtree,trie,avlset]"
+                      << " [--threads=1,8] [--format=table|csv|json] [--samples=N] [--seed=N]" << std::endl;
+            std::exit(arg == "--help" ? 0 : 1);
+        }
+    }
+    return opt;
+}
+
+
+int main(int argc, char** argv) {
+    Options opt = parseOptions(argc, argv);
+
+    bool first = true;
+    for(size_t n : opt.sizes) {
+        for(const std::string& dist : opt.dists) {
+            std::vector<int> keys = makeKeys(dist, n, opt.seed);
+            std::vector<int> probes = makeProbes(dist, keys, opt.seed + 1);
+
+            for(const std::string& structure : opt.structures) {
+                for(const Result& r : runStructure(structure, dist, n, keys, probes, opt)) {
+                    report(r, opt, first);
+                    first = false;
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,363 @@
+#include "AVLTree.h"
+#include "BinaryImage.h"
+
+#include "CheckAVL.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main() {
+    AVLTree tree;
+
+    // When tree empty
+    auto f = tree.search(5);
+    std::cout << "search when tree is empty" << std::endl;
+    std::cout << "Result: " << f << std::endl;
+
+    // More or less balanced
+    tree.insert(5);
+    tree.insert(2);
+    tree.insert(3);
+    tree.insert(4);
+    tree.insert(6);
+    tree.insert(7);
+    tree.insert(1);
+    tree.insert(8);
+    tree.insert(9);
+
+    // auto g = tree.search(1);
+    // watch("search when present");
+    // watch(g);
+
+    // auto h = tree.search(99);
+    // watch("search when absent")
+    // watch(h);
+
+    /*
+    Delete individually and check
+    1 leaf (left child)
+    4 leaf (right child)
+    2 one child left
+    6 one child right
+    3 two child (left child of root)
+    7 two child (right child of root)
+    5 two child root
+    */
+
+    int del = 5;
+    bool y = tree.remove(del);
+    std::cout << "delete " << del << std::endl;
+    std::cout << "Was deletion a success? " << std::boolalpha << y << std::endl;
+    tree.prettyPrint();
+
+
+    // Set operations
+    // Multiples of 2 and multiples of 3 in [0, 3000)
+    const int N = 3000;
+    AVLTree a, b, c, d, lo, hi;
+    for(int i = 0; i < N; ++i) {
+        if(i % 2 == 0) {
+            a.insert(i);
+            c.insert(i);
+        }
+        if(i % 3 == 0) {
+            b.insert(i);
+        }
+    }
+
+    a.unionWith(b);
+    assert(b.root == nullptr);
+    checkAVL(a.root);
+    for(int i = 0; i < N; ++i) {
+        assert((a.search(i) != nullptr) == (i % 2 == 0 || i % 3 == 0));
+    }
+
+    for(int i = 0; i < N; i += 3) {
+        d.insert(i);
+    }
+    c.intersectWith(d);
+    checkAVL(c.root);
+    for(int i = 0; i < N; ++i) {
+        assert((c.search(i) != nullptr) == (i % 6 == 0));
+    }
+
+    // (multiples of 2 or 3) - (multiples of 6)
+    a.differenceWith(c);
+    checkAVL(a.root);
+    for(int i = 0; i < N; ++i) {
+        assert((a.search(i) != nullptr) == ((i % 2 == 0) != (i % 3 == 0)));
+    }
+
+    assert(a.split(1502, lo, hi) == true);
+    assert(a.root == nullptr);
+    checkAVL(lo.root);
+    checkAVL(hi.root);
+    assert(lo.search(1498) != nullptr && lo.search(1504) == nullptr);
+    assert(hi.search(1504) != nullptr && hi.search(1498) == nullptr);
+
+    lo.join(hi);
+    checkAVL(lo.root);
+    assert(lo.search(1502) == nullptr);
+    assert(lo.search(1498) != nullptr && lo.search(1504) != nullptr);
+
+    bool rejected = false;
+    AVLTree notEmpty;
+    notEmpty.insert(1);
+    try {
+        lo.split(10, notEmpty, hi);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    assert(rejected);
+    assert(lo.search(10) != nullptr);
+
+    // Trees tall enough for the set operations to fork tasks, on 4
+    // threads whatever the machine
+    const int BIG = 1 << 17;
+    std::vector<int> twos, threes;
+    for(int i = 0; i < BIG; ++i) {
+        if(i % 2 == 0)
+            twos.push_back(i);
+        if(i % 3 == 0)
+            threes.push_back(i);
+    }
+    AVLTree bigA, bigB, bigC, bigD;
+    bigA.buildFromSorted(twos);
+    bigB.buildFromSorted(threes);
+    bigC.buildFromSorted(twos);
+    bigD.buildFromSorted(threes);
+    assert(height(bigB.root) >= 15);
+
+    bigA.unionWith(bigB, 4);
+    bigC.intersectWith(bigD, 4);
+    checkAVL(bigA.root);
+    checkAVL(bigC.root);
+    for(int i = 0; i < BIG; ++i) {
+        assert((bigA.search(i) != nullptr) == (i % 2 == 0 || i % 3 == 0));
+        assert((bigC.search(i) != nullptr) == (i % 6 == 0));
+    }
+    bigA.differenceWith(bigC, 4);
+    checkAVL(bigA.root);
+    for(int i = 0; i < BIG; ++i) {
+        assert((bigA.search(i) != nullptr) == ((i % 2 == 0) != (i % 3 == 0)));
+    }
+    std::cout << "Set operations work correctly" << std::endl;
+
+
+    // Bulk loading, the right ladder without any rotation
+    std::vector<int> odds, evens;
+    for(int i = 0; i < 1023; ++i) {
+        evens.push_back(2 * i);
+        odds.push_back(2 * i + 1);
+    }
+
+    AVLTree bulk;
+    bulk.buildFromSorted(odds);
+    assert(checkAVL(bulk.root) == 9);
+
+    bulk.insertBatch(evens);
+    checkAVL(bulk.root);
+    for(int i = 0; i < 2 * 1023; ++i) {
+        assert(bulk.search(i) != nullptr);
+    }
+    assert(bulk.search(-1) == nullptr && bulk.search(2 * 1023) == nullptr);
+
+    // Batch of values on one side of the tree
+    bulk.insertBatch(std::vector<int>{5000, 5001, 5002, 5003, 5004});
+    checkAVL(bulk.root);
+    assert(bulk.search(5004) != nullptr);
+    std::cout << "Bulk loading works correctly" << std::endl;
+
+
+    // Iterators and range scans
+    AVLTree scan;
+    for(int i = 10; i > 0; --i) {
+        scan.insert(10 * i);
+    }
+
+    std::vector<int> seen(scan.begin(), scan.end());
+    assert(seen == std::vector<int>({10, 20, 30, 40, 50, 60, 70, 80, 90, 100}));
+
+    std::vector<int> reversed;
+    for(auto p = scan.end(); p != scan.begin();) {
+        reversed.push_back(*--p);
+    }
+    assert(std::equal(reversed.rbegin(), reversed.rend(), seen.begin()));
+
+    assert(*scan.lower_bound(40) == 40);
+    assert(*scan.lower_bound(41) == 50);
+    assert(*scan.upper_bound(40) == 50);
+    assert(scan.lower_bound(101) == scan.end());
+    assert(*--scan.lower_bound(101) == 100);
+    assert(scan.lower_bound(-5) == scan.begin());
+
+    std::vector<int> range;
+    scan.forEachInRange(25, 70, [&](int v) { range.push_back(v); });
+    assert(range == std::vector<int>({30, 40, 50, 60, 70}));
+
+    AVLTree empty;
+    assert(empty.begin() == empty.end());
+    assert(empty.lower_bound(0) == empty.end());
+    std::cout << "Iterators work correctly" << std::endl;
+
+
+    // Printing and exports
+    AVLTree small;
+    small.insert(2);
+    small.insert(1);
+    small.insert(3);
+
+    std::stringstream printed;
+    small.prettyPrint(printed);
+    assert(printed.str() ==
+        "      <2,1>\n"
+        "<1,0>       <3,0>\n");
+
+    std::stringstream dot;
+    small.exportDot(dot);
+    assert(dot.str() ==
+        "digraph AVLTree {\n"
+        "  n0 [label=\"2 (h=1)\"];\n"
+        "  n1 [label=\"1 (h=0)\"];\n"
+        "  n2 [label=\"3 (h=0)\"];\n"
+        "  n0 -> n1;\n"
+        "  n0 -> n2;\n"
+        "}\n");
+
+    std::stringstream json;
+    small.exportJson(json);
+    assert(json.str() ==
+        "{\"val\":2,\"height\":1,"
+        "\"left\":{\"val\":1,\"height\":0,\"left\":null,\"right\":null},"
+        "\"right\":{\"val\":3,\"height\":0,\"left\":null,\"right\":null}}\n");
+
+    // A tree of depth 19 only prints its top levels
+    std::vector<int> many(1 << 20);
+    for(size_t i = 0; i < many.size(); ++i) {
+        many[i] = i;
+    }
+    AVLTree deep;
+    deep.buildFromSorted(many);
+
+    std::stringstream truncated;
+    deep.prettyPrint(truncated, 3);
+    std::string line, last;
+    int rows = 0;
+    while(std::getline(truncated, line)) {
+        ++rows;
+        assert(line.size() < 16 * 16);
+        last = line;
+    }
+    assert(rows == 5);
+    assert(last == "... 15 nodes shown, tree truncated");
+    std::cout << "Printing works correctly" << std::endl;
+
+    // Save and load keep the exact shape
+    AVLTree saved;
+    for(int i = 0; i < 5000; ++i) {
+        saved.insert(i * 7919 % 10007);
+    }
+    saved.save("AVLTreeTest.img");
+
+    AVLTree loaded;
+    loaded.insert(42);
+    loaded.load("AVLTreeTest.img");
+    checkAVL(loaded.root);
+    std::stringstream savedJson, loadedJson;
+    saved.exportJson(savedJson);
+    loaded.exportJson(loadedJson);
+    assert(savedJson.str() == loadedJson.str());
+
+    AVLTree none;
+    none.save("AVLTreeTest.img");
+    loaded.load("AVLTreeTest.img");
+    assert(loaded.root == nullptr);
+
+    // A damaged image is rejected and the tree left as it was
+    saved.save("AVLTreeTest.img");
+    {
+        std::fstream f("AVLTreeTest.img", std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(64 + 8 * 100);
+        f.put('x');
+    }
+    rejected = false;
+    try {
+        loaded.load("AVLTreeTest.img");
+    } catch (const std::runtime_error& e) {
+        rejected = std::string(e.what()) == "image checksum mismatch";
+    }
+    assert(rejected);
+    assert(loaded.root == nullptr);
+
+    // Intact images of a left chain, whose node i has height heights(i)
+    auto loadChain = [&](int n, int (*heights)(int)) {
+        {
+            ImageWriter writer("AVLTreeTest.img", "AVLTREE");
+            for(int i = 0; i < n; ++i) {
+                uint32_t rec[2] = {uint32_t(n - i), uint32_t(heights(i) << 2 | (i + 1 < n ? 2 : 0))};
+                writer.write(rec, sizeof(rec));
+            }
+            writer.finish(n);
+        }
+        try {
+            loaded.load("AVLTreeTest.img");
+        } catch (const std::runtime_error& e) {
+            assert(loaded.root == nullptr);
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    // Too deep for the iterators, with consistent heights or without any
+    assert(loadChain(200, [](int i) { return 199 - i; }) == "AVL tree image has a wrong height");
+    assert(loadChain(200, [](int) { return 0; }) == "AVL tree image has a wrong height");
+    assert(loadChain(3, [](int i) { return 2 - i; }) == "AVL tree image is not balanced");
+    assert(loadChain(2, [](int i) { return 1 - i; }) == "");
+    checkAVL(loaded.root);
+
+    // An unfinished image leaves nothing behind
+    {
+        ImageWriter writer("AVLTreeTest.unfinished", "AVLTREE");
+        writer.write("abcdefgh", 8);
+    }
+    assert(!std::ifstream("AVLTreeTest.unfinished.tmp"));
+    assert(!std::ifstream("AVLTreeTest.unfinished"));
+    assert(!std::ifstream("AVLTreeTest.img.tmp"));
+
+    std::remove("AVLTreeTest.img");
+    std::cout << "Save and load work correctly" << std::endl;
+
+
+
+
+    // Right ladder
+    // tree.insert(1);
+    // tree.insert(2);
+    // tree.insert(3);
+    // tree.insert(4);
+    // tree.insert(5);
+    // tree.insert(6);
+
+    // Left ladder
+    // tree.insert(6);
+    // tree.insert(5);
+    // tree.insert(4);
+    // tree.insert(3);
+    // tree.insert(2);
+    // tree.insert(1);
+    
+    
+
+    // printInorder(tree.root);
+
+    // If tree gets too deep, only the top levels are printed
+    // tree.prettyPrint();
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#ifndef CHECKAVL_H
+#define CHECKAVL_H
+
+#include "CompactAVLTree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+/**
+* Invariant checks shared by the tree tests
+*/
+
+
+/**
+* Child pointer of a node, whether it is plain or atomic
+*/
+template<typename Node>
+Node* child(Node* p) {
+    return p;
+}
+
+
+template<typename Node>
+Node* child(const std::atomic<Node*>& p) {
+    return p.load();
+}
+
+
+/**
+* Asserts that the subtree is balanced, with correct heights, and calls
+* `check(node)` on every node for the other invariants.
+* Returns its height.
+*/
+template<typename Node, typename Check>
+int checkAVL(Node* node, Check check) {
+    if(node == nullptr)
+        return -1;
+
+    check(node);
+
+    int hl = checkAVL(child(node->left), check);
+    int hr = checkAVL(child(node->right), check);
+    assert(std::abs(hl - hr) <= 1);
+    assert(node->height == std::max(hl, hr) + 1);
+    return node->height;
+}
+
+
+/**
+* Asserts that the subtree is ordered by `val` and balanced, with correct
+* heights. Returns its height.
+*/
+template<typename Node>
+int checkAVL(Node* node) {
+    return checkAVL(node, [](Node* n) {
+        Node* l = child(n->left);
+        Node* r = child(n->right);
+        assert(l == nullptr || l->val < n->val);
+        assert(r == nullptr || r->val > n->val);
+    });
+}
+
+
+/**
+* Same as above, for the subtree of `tree` rooted at index `i`
+*/
+inline int checkAVL(const CompactAVLTree& tree, uint32_t i) {
+    if(i == NIL)
+        return -1;
+
+    const CompactAVLNode& n = tree.at(i);
+    assert(n.getLeft() == NIL || tree.at(n.getLeft()).val < n.val);
+    assert(n.getRight() == NIL || tree.at(n.getRight()).val > n.val);
+
+    int hl = checkAVL(tree, n.getLeft());
+    int hr = checkAVL(tree, n.getRight());
+    assert(std::abs(hl - hr) <= 1);
+    assert(n.getHeight() == std::max(hl, hr) + 1);
+    return n.getHeight();
+}
+
+
+#endif // CHECKAVL_H
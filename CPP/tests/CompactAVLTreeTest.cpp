@@ -0,0 +1,69 @@
+#include "CompactAVLTree.h"
+
+#include "CheckAVL.h"
+
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <vector>
+
+
+int main() {
+    static_assert(sizeof(CompactAVLNode) == 12, "node should take 12 bytes");
+
+    // Height is split across both links
+    CompactAVLNode n(7);
+    n.setLeft(12345);
+    n.setRight(NIL);
+    n.setHeight(42);
+    assert(n.getLeft() == 12345 && n.getRight() == NIL && n.getHeight() == 42);
+    n.setLeft(1);
+    assert(n.getHeight() == 42);
+
+    // Insert and remove, checked against std::set
+    CompactAVLTree tree;
+    std::set<int> ref;
+    unsigned x = 12345;
+    for(int k = 0; k < 20000; ++k) {
+        x = x * 1103515245 + 12345;
+        int v = (x >> 8) % 5000;
+        if(k % 3 == 2) {
+            assert(tree.remove(v) == (ref.erase(v) == 1));
+        } else if (!ref.count(v)) {
+            tree.insert(v);
+            ref.insert(v);
+        }
+    }
+    checkAVL(tree, tree.root);
+    assert(tree.size() == ref.size());
+    for(int v = -1; v <= 5000; ++v) {
+        assert(tree.search(v) == (ref.count(v) == 1));
+    }
+
+    tree.relayout(Layout::BFS);
+    checkAVL(tree, tree.root);
+    assert(tree.at(tree.root).val == tree.at(0).val);
+    for(int v : ref) {
+        assert(tree.search(v));
+    }
+    std::cout << "Insertion and deletion work correctly" << std::endl;
+
+    // Bulk load in each layout
+    std::vector<int> v;
+    for(int i = 0; i < 10000; ++i) {
+        v.push_back(3 * i);
+    }
+    for(Layout layout : {Layout::PREORDER, Layout::BFS, Layout::VEB}) {
+        CompactAVLTree bulk;
+        bulk.buildFromSorted(v, layout);
+        assert(bulk.root == 0);
+        assert(checkAVL(bulk, bulk.root) == 13);
+        for(int i = 0; i < 30000; ++i) {
+            assert(bulk.search(i) == (i % 3 == 0));
+        }
+        assert(bulk.memoryUsage() == sizeof(bulk) + 12 * v.size());
+    }
+    std::cout << "Bulk loading works correctly" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "ConcurrentAVLTree.h"
+
+#include "CheckAVL.h"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+int main() {
+    ConcurrentAVLTree tree;
+
+    // Single threaded
+    assert(tree.search(5) == false);
+    for(int i = 0; i < 100; ++i) {
+        assert(tree.insert(i) == true);
+    }
+    assert(tree.insert(50) == false);
+    checkAVL(tree.getRoot());
+
+    for(int i = 0; i < 100; i += 2) {
+        assert(tree.remove(i) == true);
+    }
+    assert(tree.remove(50) == false);
+    checkAVL(tree.getRoot());
+    for(int i = 0; i < 100; ++i) {
+        assert(tree.search(i) == (i % 2 == 1));
+    }
+
+    // Routing nodes are revived by insert
+    assert(tree.insert(50) == true);
+    assert(tree.search(50) == true);
+    checkAVL(tree.getRoot());
+    std::cout << "Insertion and deletion work correctly" << std::endl;
+
+
+    // Readers racing one writer.
+    // Multiples of 4 stay in the tree, everything else comes and goes.
+    const int N = 4000;
+    ConcurrentAVLTree shared;
+    for(int i = 0; i < N; i += 4) {
+        shared.insert(i);
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int> misses(0);
+    std::vector<std::thread> readers;
+    for(int t = 0; t < 3; ++t) {
+        readers.emplace_back([&, t]() {
+            unsigned x = 7 + t;
+            while(!done.load()) {
+                x = x * 1103515245 + 12345;
+                int v = 4 * ((x >> 8) % (N / 4));
+                if(!shared.search(v)) {
+                    misses.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for(int round = 0; round < 20; ++round) {
+        for(int i = 1; i < N; ++i) {
+            if(i % 4 != 0)
+                shared.insert(i);
+        }
+        for(int i = N - 1; i > 0; --i) {
+            if(i % 4 != 0)
+                shared.remove(i);
+        }
+    }
+    done.store(true);
+    for(std::thread& r : readers) {
+        r.join();
+    }
+
+    assert(misses.load() == 0);
+    checkAVL(shared.getRoot());
+    for(int i = 0; i < N; ++i) {
+        assert(shared.search(i) == (i % 4 == 0));
+    }
+    std::cout << "Concurrent reads work correctly" << std::endl;
+
+
+    // More threads than reader slots, all alive at once: slots are only
+    // held during a search
+    const int THREADS = EpochReclaimer::READER_SLOTS + 72;
+    std::atomic<int> searched(0);
+    std::atomic<int> found(0);
+    std::vector<std::thread> pool;
+    for(int t = 0; t < THREADS; ++t) {
+        pool.emplace_back([&, t]() {
+            found.fetch_add(shared.search(4 * t));
+            searched.fetch_add(1);
+            while(searched.load() < THREADS) {
+                std::this_thread::yield();
+            }
+            found.fetch_add(shared.search(4 * t + 1));
+        });
+    }
+    for(std::thread& p : pool) {
+        p.join();
+    }
+    assert(found.load() == THREADS);
+    std::cout << "Many reader threads work correctly" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "AVLTree.h"
+#include "Instrumentation.h"
+#include "SegmentTree.h"
+#include "Trie.h"
+
+#include "CheckAVL.h"
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+
+int main() {
+    assert(Instrumentation::enabled());
+    Instrumentation::reset();
+
+    // One rotation of each kind
+    AVLTree rr, ll, rl, lr;
+    for(int v : {1, 2, 3}) rr.insert(v);
+    for(int v : {3, 2, 1}) ll.insert(v);
+    for(int v : {1, 3, 2}) rl.insert(v);
+    for(int v : {3, 1, 2}) lr.insert(v);
+
+    Instrumentation::Snapshot s = Instrumentation::snapshot();
+    assert(s[Instrumentation::AVL_ROTATIONS_RR] == 1);
+    assert(s[Instrumentation::AVL_ROTATIONS_LL] == 1);
+    assert(s[Instrumentation::AVL_ROTATIONS_RL] == 1);
+    assert(s[Instrumentation::AVL_ROTATIONS_LR] == 1);
+
+    // Removing 4 from 3 / (2 / 1, 4) leaves it left heavy: one LL rotation
+    AVLTree del;
+    for(int v : {3, 2, 4, 1}) del.insert(v);
+    del.remove(4);
+    s = Instrumentation::snapshot();
+    assert(s[Instrumentation::AVL_ROTATIONS_LL] == 2);
+
+    // Removing 8 from 5 / (2 / (-, 3), 8) leaves the left child right
+    // heavy: one LR rotation, and the mirror case is RL
+    AVLTree delLR, delRL;
+    for(int v : {5, 2, 8, 3}) delLR.insert(v);
+    for(int v : {5, 2, 8, 7}) delRL.insert(v);
+    delLR.remove(8);
+    delRL.remove(2);
+    s = Instrumentation::snapshot();
+    assert(s[Instrumentation::AVL_ROTATIONS_LR] == 2);
+    assert(s[Instrumentation::AVL_ROTATIONS_RL] == 2);
+    assert(s[Instrumentation::AVL_ROTATIONS_LL] == 2);
+    assert(checkAVL(delLR.root) == 1 && delLR.root->val == 3);
+    assert(checkAVL(delRL.root) == 1 && delRL.root->val == 7);
+
+    // `rr` is 2 / (1, 3)
+    rr.search(2);       // visits 2
+    rr.search(3);       // visits 2, 3
+    rr.search(4);       // visits 2, 3
+    s = Instrumentation::snapshot();
+    assert(s[Instrumentation::AVL_SEARCHES] == 3);
+    assert(s[Instrumentation::AVL_SEARCH_VISITS] == 5);
+
+    std::vector<int> v = {1, 2, 3, 4, 5};
+    SegmentTree st(v, [](int a, int b) {return a + b;}, 0);
+    st.query(0, 4);     // the root covers it
+    st.query(0, 2);     // the root, then [0:2]
+    s = Instrumentation::snapshot();
+    assert(s[Instrumentation::SEGTREE_QUERIES] == 2);
+    assert(s[Instrumentation::SEGTREE_QUERY_VISITS] == 3);
+
+    Trie t;
+    t.insert("ab");
+    t.insert("abcd");
+    t.insert("ab");
+    s = Instrumentation::snapshot();
+    assert(s[Instrumentation::TRIE_INSERTS] == 3);
+    assert(s[Instrumentation::TRIE_NODE_ALLOCATIONS] == 4);
+
+    std::ostringstream out;
+    out << s;
+    assert(out.str().find("avl_rotations_rr 1\n") != std::string::npos);
+    assert(out.str().find("trie_node_allocations 4\n") != std::string::npos);
+
+    Instrumentation::reset();
+    s = Instrumentation::snapshot();
+    for(int c = 0; c < Instrumentation::COUNTER_COUNT; ++c) {
+        assert(s.values[c] == 0);
+    }
+
+    // Hardware counters are often unavailable, e.g. in containers
+    if(Instrumentation::startCacheMissSampling()) {
+        AVLTree big;
+        for(int i = 0; i < 100000; ++i) {
+            big.insert(i * 7919 % 100003);
+        }
+        s = Instrumentation::snapshot();
+        assert(s.hasCacheMisses);
+        std::cout << "cache misses: " << s.cacheMisses << std::endl;
+        Instrumentation::stopCacheMissSampling();
+    } else {
+        std::cout << "cache misses: not available" << std::endl;
+    }
+    assert(!Instrumentation::snapshot().hasCacheMisses);
+
+    return 0;
+}
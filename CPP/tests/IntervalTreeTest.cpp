@@ -0,0 +1,98 @@
+#include "IntervalTree.h"
+
+#include "CheckAVL.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+
+/**
+* Asserts that the subtree is ordered and balanced, with correct heights
+* and `maxHi`. Returns its height.
+*/
+int checkIntervals(IntervalNode* node) {
+    return checkAVL(node, [](IntervalNode* n) {
+        int m = n->hi;
+        if(n->left) {
+            assert(std::make_pair(n->left->lo, n->left->hi) <= std::make_pair(n->lo, n->hi));
+            m = std::max(m, n->left->maxHi);
+        }
+        if(n->right) {
+            assert(std::make_pair(n->right->lo, n->right->hi) >= std::make_pair(n->lo, n->hi));
+            m = std::max(m, n->right->maxHi);
+        }
+        assert(n->maxHi == m);
+    });
+}
+
+
+int main() {
+    IntervalTree tree;
+
+    assert(tree.findAnyOverlap(0, 100) == nullptr);
+
+    // Interval i covers [10 * i, 10 * i + len], with a few long ones
+    std::vector<std::pair<int, int>> all;
+    for(int i = 0; i < 200; ++i) {
+        int len = (i % 17 == 0) ? 300 : i % 7;
+        all.push_back(std::make_pair(10 * i, 10 * i + len));
+        tree.insert(10 * i, 10 * i + len);
+    }
+    checkIntervals(tree.root);
+
+    // Compare every query against a linear scan
+    auto check = [&](int lo, int hi) {
+        std::vector<std::pair<int, int>> expected, found;
+        for(auto& p : all) {
+            if(p.first <= hi && lo <= p.second)
+                expected.push_back(p);
+        }
+        tree.forEachOverlap(lo, hi, [&](IntervalNode* n) {
+            found.push_back(std::make_pair(n->lo, n->hi));
+        });
+        std::sort(expected.begin(), expected.end());
+        assert(found == expected);
+
+        IntervalNode* any = tree.findAnyOverlap(lo, hi);
+        assert((any != nullptr) == !expected.empty());
+        assert(any == nullptr || any->overlaps(lo, hi));
+    };
+
+    for(int lo = -20; lo < 2100; lo += 7) {
+        check(lo, lo);
+        check(lo, lo + 3);
+        check(lo, lo + 45);
+    }
+
+    int stabbed = 0;
+    tree.forEachStabbing(175, [&](IntervalNode* n) {
+        assert(n->lo <= 175 && 175 <= n->hi);
+        ++stabbed;
+    });
+    // [0, 300] and [170, 470]
+    assert(stabbed == 2);
+    std::cout << "Overlap queries work correctly" << std::endl;
+
+    // Deletion keeps `maxHi` right, including the predecessor swap
+    for(size_t i = 0; i < all.size(); i += 3) {
+        assert(tree.remove(all[i].first, all[i].second) == true);
+        checkIntervals(tree.root);
+    }
+    assert(tree.remove(5, 6) == false);
+
+    std::vector<std::pair<int, int>> kept;
+    for(size_t i = 0; i < all.size(); ++i) {
+        if(i % 3 != 0)
+            kept.push_back(all[i]);
+    }
+    all.swap(kept);
+    for(int lo = -20; lo < 2100; lo += 7) {
+        check(lo, lo + 20);
+    }
+    std::cout << "Deletion works correctly" << std::endl;
+
+    return 0;
+}
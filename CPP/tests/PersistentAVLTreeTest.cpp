@@ -0,0 +1,76 @@
+#include "PersistentAVLTree.h"
+#include "Instrumentation.h"
+
+#include "CheckAVL.h"
+
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+
+/**
+* Number of nodes currently allocated, by all trees
+*/
+long liveNodes() {
+    Instrumentation::Snapshot s = Instrumentation::snapshot();
+    return long(s[Instrumentation::PERSISTENT_NODE_ALLOCATIONS] -
+        s[Instrumentation::PERSISTENT_NODE_FREES]);
+}
+
+
+int main() {
+    // Node counts come from the instrumented build
+    assert(Instrumentation::enabled());
+
+    {
+        PersistentAVLTree tree;
+        for(int i = 0; i < 1000; ++i) {
+            tree.insert(i);
+        }
+        checkAVL(tree.getRoot());
+
+        PersistentAVLTree before = tree.snapshot();
+        assert(before.getRoot() == tree.getRoot());
+        long shared = liveNodes();
+
+        // Path copying only allocates O(log n) nodes per update
+        assert(tree.remove(500) == true);
+        assert(tree.remove(5000) == false);
+        tree.insert(1000);
+        assert(liveNodes() - shared < 4 * 2 * 12);
+
+        checkAVL(tree.getRoot());
+        checkAVL(before.getRoot());
+        assert(tree.search(500) == nullptr && tree.search(1000) != nullptr);
+        assert(before.search(500) != nullptr && before.search(1000) == nullptr);
+
+        // Remove every value, two children cases included
+        for(int i = 0; i < 1000; i += 3) {
+            tree.remove(i);
+            checkAVL(tree.getRoot());
+        }
+        for(int i = 0; i < 1000; ++i) {
+            assert((tree.search(i) != nullptr) == (i % 3 != 0 && i != 500));
+            assert(before.search(i) != nullptr);
+        }
+
+        // A long running report on the snapshot, while the tree changes
+        PersistentAVLTree report = tree.snapshot();
+        long sum = 0;
+        std::thread reader([&]() {
+            report.forEachInRange(100, 199, [&](int v) { sum += v; });
+        });
+        for(int i = 100; i < 200; ++i) {
+            tree.remove(i);
+        }
+        reader.join();
+        assert(sum == (100 + 199) * 100 / 2 - (102 + 198) * 33 / 2);
+        std::cout << "Snapshots work correctly" << std::endl;
+    }
+
+    // Every version has been released
+    assert(liveNodes() == 0);
+    std::cout << "Old versions are reclaimed" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "SegmentTree.h"
+#include "AVLTree.h"
+#include "BinaryImage.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+int main() {
+
+    std::vector<int> v = {1, 2, 3, 4, 5};
+
+    auto add = [](int a, int b) {return a + b;};
+    int default_add = 0;
+    SegmentTree st(v, add, default_add);
+    /*
+                       [0:4]=15
+                      /        \
+              [0:2]= 6         [3:4]= 9
+               / \             /    \
+        [0:1]=3   [2]=3    [3]=4   [4]=5
+         /   \
+    [0]=1   [1]=2
+
+    */
+
+
+    // Addition tree
+    assert(st.query(0, 2) == 6);
+    assert(st.query(1, 3) == 9);
+    assert(st.query(4, 4) == 5);
+    assert(st.query(0, 0) == 1);
+
+    st.update(2, 7);
+
+    assert(st.query(2, 4) == 16);
+
+    std::cout << "Addition works correctly" << std::endl;
+
+
+    // Multiplication
+    std::vector<int> mv = {1, 2, 3, 4, 5};
+    auto mul = [](int a, int b) {return a * b;};
+    int mul_default = 1;
+    SegmentTree mst(mv, mul, mul_default);
+    /*
+                        [0:4]=120
+                      /        \
+              [0:2]= 6         [3:4]= 20
+               / \             /    \
+        [0:1]=2   [2]=3    [3]=4   [4]=5
+         /   \
+    [0]=1   [1]=2
+    */
+
+    assert(mst.query(0, 2) == 6);
+    assert(mst.query(1, 3) == 24);
+    assert(mst.query(0, 4) == 120);
+    assert(mst.query(1, 2) == 6);
+
+    mst.update(1, 7);
+    assert(mst.query(1, 4) == 420);
+
+    std::cout << "Multiplication works correctly" << std::endl;
+
+
+    // Save and load
+    mst.save("SegmentTreeTest.img");
+    SegmentTree lst = SegmentTree::load("SegmentTreeTest.img", mul);
+    assert(lst.query(1, 4) == 420);
+    assert(lst.query(0, 4) == 420);
+    lst.update(0, 2);
+    assert(lst.query(0, 4) == 840);
+
+    // The image of another structure, or a cut short one, is rejected
+    bool rejected = false;
+    try {
+        AVLTree().save("SegmentTreeTest.img");
+        SegmentTree::load("SegmentTreeTest.img", mul);
+    } catch (const std::runtime_error& e) {
+        rejected = std::string(e.what()) == "not an image of SEGTREE";
+    }
+    assert(rejected);
+
+    mst.save("SegmentTreeTest.img");
+    {
+        std::ifstream in("SegmentTreeTest.img", std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out("SegmentTreeTest.img", std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size() - 4);
+    }
+    rejected = false;
+    try {
+        SegmentTree::load("SegmentTreeTest.img", mul);
+    } catch (const std::runtime_error& e) {
+        rejected = std::string(e.what()) == "image truncated";
+    }
+    assert(rejected);
+
+    // The header is checksummed too: a changed default value is caught
+    mst.save("SegmentTreeTest.img");
+    {
+        std::fstream f("SegmentTreeTest.img", std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(offsetof(ImageHeader, meta) + sizeof(int64_t));
+        f.put(7);
+    }
+    rejected = false;
+    try {
+        SegmentTree::load("SegmentTreeTest.img", mul);
+    } catch (const std::runtime_error& e) {
+        rejected = std::string(e.what()) == "image checksum mismatch";
+    }
+    assert(rejected);
+
+    // Intact images whose size does not match their number of leaves
+    auto loadForged = [&](uint64_t count, int64_t vn) {
+        {
+            ImageWriter writer("SegmentTreeTest.img", "SEGTREE");
+            std::vector<int> payload(count, 1);
+            writer.write(payload.data(), payload.size() * sizeof(int));
+            writer.finish(count, vn, 0);
+        }
+        try {
+            SegmentTree::load("SegmentTreeTest.img", mul);
+        } catch (const std::runtime_error& e) {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    assert(loadForged(20, 5) == "");
+    assert(loadForged(20, 5 | int64_t(1) << 62) == "segment tree image has a bad size");
+    assert(loadForged(0, 0) == "segment tree image has a bad size");
+    assert(loadForged(22, 5) == "segment tree image has a bad size");
+    std::remove("SegmentTreeTest.img");
+
+    std::cout << "Save and load work correctly" << std::endl;
+
+    return 0;
+}
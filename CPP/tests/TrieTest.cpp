@@ -0,0 +1,100 @@
+#include "Trie.h"
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+int main() {
+    Trie t;
+
+    t.insert("abcd");
+    t.insert("ab");
+    assert(t.search("abc") == false);
+    assert(t.search("abc", true) == true);
+    assert(t.search("ab")  ==  true);
+    assert(t.search("xyz") == false);
+    assert(t.search("xyz", true) == false);
+    assert(t.size() == 2);
+
+    // Values
+    ByteTrie<int> bt;
+    assert(bt.put("car", 1));
+    assert(bt.put("cart", 2));
+    assert(!bt.put("car", 3));
+    assert(*bt.get("car") == 3);
+    assert(*bt.get("cart") == 2);
+    assert(bt.get("ca") == nullptr);
+    assert(bt.get("carts") == nullptr);
+    assert(bt.size() == 2);
+
+    // Erasing "cart" removes its last node, erasing "car" then
+    // leaves only the root
+    assert(!bt.erase("ca"));
+    assert(bt.erase("cart"));
+    assert(!bt.erase("cart"));
+    assert(bt.search("car"));
+    assert(bt.memoryUsage().nodes[ByteTrie<int>::LEAF] == 1);
+    assert(bt.erase("car"));
+    assert(bt.size() == 0);
+    ByteTrie<int>::MemoryUsage empty = bt.memoryUsage();
+    assert(empty.nodes[ByteTrie<int>::LEAF] == 1);
+    assert(empty.nodes[ByteTrie<int>::LIST] == 0);
+
+    // A node with many children becomes DIRECT, and a LIST again
+    // once most of them are erased
+    for(int c = 0; c < 256; ++c) {
+        bt.put(std::string(1, char(c)), c);
+    }
+    assert(*bt.get(std::string(1, char(200))) == 200);
+    ByteTrie<int>::MemoryUsage full = bt.memoryUsage();
+    assert(full.nodes[ByteTrie<int>::DIRECT] == 1);
+    assert(full.nodes[ByteTrie<int>::LEAF] == 256);
+    assert(full.totalBytes() > 256 * sizeof(void*));
+    for(int c = 0; c < 250; ++c) {
+        assert(bt.erase(std::string(1, char(c))));
+    }
+    assert(bt.memoryUsage().nodes[ByteTrie<int>::DIRECT] == 0);
+    assert(bt.memoryUsage().nodes[ByteTrie<int>::LIST] == 1);
+    assert(*bt.get(std::string(1, char(255))) == 255);
+    assert(bt.size() == 6);
+
+    // Nibbles: "a" = 0x61 is the path 6, 1
+    NibbleTrie<std::string> nt;
+    nt.put("a", "first");
+    nt.put("b", "second");
+    assert(*nt.get("a") == "first");
+    assert(*nt.get("b") == "second");
+    assert(nt.search(std::string(), true));
+    NibbleTrie<std::string>::MemoryUsage nu = nt.memoryUsage();
+    assert(nu.nodes[NibbleTrie<std::string>::LIST] == 2);
+    assert(nu.nodes[NibbleTrie<std::string>::LEAF] == 2);
+
+    // Token ids
+    TokenTrie<uint16_t, double> tt;
+    std::vector<uint16_t> hello = {15496, 995};
+    std::vector<uint16_t> help = {15496, 1037};
+    tt.put(hello, 0.5);
+    tt.put(help, 0.25);
+    assert(*tt.get(hello) == 0.5);
+    assert(tt.search(std::vector<uint16_t>(1, 15496), true));
+    assert(!tt.search(std::vector<uint16_t>(1, 15496)));
+    assert(tt.erase(help));
+    assert(tt.get(help) == nullptr);
+
+    // Token 0 is a symbol like any other, not the end of the key
+    static_assert(!std::is_convertible<const uint16_t*, TrieKey<uint16_t>>::value,
+        "only char keys may be zero terminated");
+    std::vector<uint16_t> zeros = {0, 0};
+    tt.put(zeros, 1.5);
+    assert(*tt.get(zeros) == 1.5);
+    assert(tt.get(std::vector<uint16_t>(1, 0)) == nullptr);
+
+    TokenTrie<uint32_t, int> wide;
+    std::vector<uint32_t> big = {4000000000u, 7};
+    wide.put(big, 1);
+    assert(*wide.get(big) == 1);
+
+    return 0;
+}
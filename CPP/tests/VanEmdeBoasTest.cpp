@@ -0,0 +1,87 @@
+#include "VanEmdeBoas.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <set>
+
+
+/**
+* Runs random operations on `veb` and on a std::set, asserting that
+* both always agree. Values are drawn from [0, range) shifted left by `shift`.
+*/
+template<int BITS>
+void checkAgainstSet(uint64_t range, int shift) {
+    VanEmdeBoas<BITS> veb;
+    std::set<uint64_t> ref;
+    uint64_t x = 88172645463325252ull;
+
+    for(int k = 0; k < 200000; ++k) {
+        // xorshift64
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        uint64_t v = (x % range) << shift;
+
+        switch(k % 5) {
+        case 0:
+        case 1:
+            assert(veb.insert(v) == ref.insert(v).second);
+            break;
+        case 2:
+            assert(veb.erase(v) == (ref.erase(v) == 1));
+            break;
+        default: {
+            uint64_t out = 0;
+            auto it = ref.upper_bound(v);
+            bool found = veb.successor(v, out);
+            assert(found == (it != ref.end()));
+            assert(!found || out == *it);
+
+            it = ref.lower_bound(v);
+            found = veb.predecessor(v, out);
+            assert(found == (it != ref.begin()));
+            assert(!found || out == *--it);
+
+            assert(veb.contains(v) == (ref.count(v) == 1));
+        }
+        }
+
+        assert(veb.size() == ref.size());
+        if(!ref.empty()) {
+            assert(veb.min() == *ref.begin());
+            assert(veb.max() == *ref.rbegin());
+        }
+    }
+}
+
+
+int main() {
+    VanEmdeBoas<16> small;
+    uint64_t out = 0;
+    assert(small.empty());
+    assert(small.successor(0, out) == false);
+    assert(small.predecessor(65535, out) == false);
+
+    small.insert(3);
+    small.insert(65535);
+    small.insert(1000);
+    assert(small.min() == 3 && small.max() == 65535);
+    assert(small.successor(3, out) && out == 1000);
+    assert(small.successor(1000, out) && out == 65535);
+    assert(small.successor(65535, out) == false);
+    assert(small.predecessor(1000, out) && out == 3);
+    assert(small.erase(3) && small.min() == 1000);
+    assert(small.erase(65535) && small.max() == 1000);
+    assert(small.erase(1000) && small.empty());
+
+    checkAgainstSet<16>(1 << 16, 0);
+    checkAgainstSet<16>(3000, 0);
+    checkAgainstSet<32>(uint64_t(1) << 32, 0);
+    checkAgainstSet<32>(5000, 10);
+    checkAgainstSet<64>(~uint64_t(0), 0);
+    checkAgainstSet<64>(5000, 40);
+    std::cout << "VanEmdeBoas matches std::set" << std::endl;
+
+    return 0;
+}